@@ -0,0 +1,310 @@
+#include <markdownify/markdownify.hpp>
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <fstream>
+#endif
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// Every heap allocation of the process is counted, so each benchmark can
+// report allocations per converted document.
+namespace {
+
+std::atomic<std::size_t> allocation_count{0};
+
+}
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+// Peak resident set size. On Linux the high-water mark is reset before each
+// benchmark, so the value belongs to that benchmark; elsewhere it is the
+// peak of the whole process so far.
+void reset_peak_rss() {
+#ifdef __linux__
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+double peak_rss_kib() {
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::strtod(line.c_str() + 6, nullptr);
+        }
+    }
+#endif
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return static_cast<double>(usage.ru_maxrss);
+    }
+#endif
+    return 0;
+}
+
+// Corpora. Each is built once and shared by all stages.
+
+std::string make_deep_lists() {
+    std::string html;
+    for (int block = 0; block < 40; ++block) {
+        for (int depth = 0; depth < 64; ++depth) {
+            html += depth % 2 ? "<ol><li>item " : "<ul><li>entry ";
+            html += std::to_string(depth);
+        }
+        for (int depth = 63; depth >= 0; --depth) {
+            html += depth % 2 ? "</li></ol>" : "</li></ul>";
+        }
+    }
+    return html;
+}
+
+std::string make_table() {
+    std::string html = "<table><thead><tr><th>id</th><th>name</th><th>price</th>"
+                       "<th>stock</th><th>note</th></tr></thead><tbody>";
+    for (int row = 0; row < 10000; ++row) {
+        std::string id = std::to_string(row);
+        html += "<tr><td>" + id + "</td><td>item_" + id + "</td><td>" +
+                std::to_string(row % 97) + ".99</td><td>" + std::to_string(row % 13) +
+                "</td><td><b>ok</b></td></tr>";
+    }
+    return html + "</tbody></table>";
+}
+
+std::string make_big_pre() {
+    std::string html = "<pre><code class=\"language-cpp\">";
+    while (html.size() < (1 << 20)) {
+        html += "for (int i = 0; i &lt; n; ++i) { total += values[i] * 2; }   \n";
+    }
+    return html + "</code></pre>";
+}
+
+std::string make_underscore_prose() {
+    std::string html;
+    for (int p = 0; p < 2000; ++p) {
+        html += "<p>Call <code>parse_html_document()</code> before the snake_case "
+                "helpers like load_user_config, save_user_config and *maybe* "
+                "reset_all_the_things_now; 2 * 3_000 = 6_000 [sic] # not a heading</p>\n";
+    }
+    return html;
+}
+
+std::string make_nav_links() {
+    std::string html = "<nav><ul>";
+    for (int i = 0; i < 5000; ++i) {
+        std::string n = std::to_string(i);
+        html += "<li><a href=\"/section/" + n + "/index.html\" title=\"Section " + n +
+                "\">Section " + n + "</a> | <a href=\"https://example.com/p/" + n + "\">" +
+                "https://example.com/p/" + n + "</a></li>";
+    }
+    return html + "</ul></nav>";
+}
+
+std::string make_tiny_fragment() {
+    return "<p>Hello <b>world</b>, see <a href=\"/x\">this</a>.</p>";
+}
+
+struct Corpus {
+    const char* name;
+    std::function<std::string()> make;
+};
+
+const Corpus kCorpora[] = {
+    {"deep_lists", make_deep_lists},
+    {"table_10k_rows", make_table},
+    {"pre_1mb", make_big_pre},
+    {"underscore_prose", make_underscore_prose},
+    {"nav_links", make_nav_links},
+    {"tiny_fragment", make_tiny_fragment},
+};
+
+std::size_t count_nodes(const markdownify::HtmlNode* node) {
+    std::size_t count = 1;
+    for (auto child = node->first_child; child; child = child->next_sibling) {
+        count += count_nodes(child);
+    }
+    return count;
+}
+
+void collect_text(const markdownify::HtmlNode* node, std::string& out) {
+    if (node->is_text()) {
+        out.append(node->value.data(), node->value.size());
+        out += ' ';
+    }
+    for (auto child = node->first_child; child; child = child->next_sibling) {
+        collect_text(child, out);
+    }
+}
+
+// Shared counters: throughput in bytes, time per element and per document,
+// allocations per document and the peak RSS of the benchmark.
+void report(benchmark::State& state, std::size_t bytes, std::size_t elements,
+            std::size_t allocations_before) {
+    std::size_t allocations = allocation_count.load() - allocations_before;
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+    state.counters["per_element"] = benchmark::Counter(
+        static_cast<double>(elements),
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    state.counters["allocs_per_doc"] =
+        static_cast<double>(allocations) / static_cast<double>(state.iterations());
+    state.counters["peak_rss_kib"] = peak_rss_kib();
+}
+
+// HTML to tree, entity decoding included, into a reused document.
+void BM_Parse(benchmark::State& state, const std::string* html) {
+    reset_peak_rss();
+    markdownify::HtmlDocument doc;
+    markdownify::HtmlParser parser(doc);
+    parser.parse_in_place(*html);
+    std::size_t nodes = doc.node_count();
+
+    std::size_t before = allocation_count.load();
+    for (auto _ : state) {
+        doc.clear();
+        parser.parse_in_place(*html);
+        benchmark::DoNotOptimize(doc.root());
+    }
+    report(state, html->size(), nodes, before);
+}
+
+// Tree to Markdown: handlers, escaping and document stripping.
+void BM_Walk(benchmark::State& state, const std::string* html) {
+    reset_peak_rss();
+    markdownify::HtmlDocument doc;
+    markdownify::HtmlParser(doc).parse_in_place(*html);
+    const markdownify::MarkdownConverter converter;
+
+    std::size_t before = allocation_count.load();
+    for (auto _ : state) {
+        std::string markdown = converter.convert_soup(doc);
+        benchmark::DoNotOptimize(markdown.data());
+    }
+    report(state, html->size(), count_nodes(doc.root()), before);
+}
+
+// Markdown escaping of all text in the document, on its own.
+void BM_Escape(benchmark::State& state, const std::string* html) {
+    reset_peak_rss();
+    markdownify::HtmlDocument doc;
+    markdownify::HtmlParser(doc).parse_in_place(*html);
+    std::string text;
+    collect_text(doc.root(), text);
+    std::string out;
+
+    std::size_t before = allocation_count.load();
+    for (auto _ : state) {
+        out.clear();
+        markdownify::escape_markdown(text, true, true, false, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    report(state, text.size(), count_nodes(doc.root()), before);
+}
+
+// Stripping of the finished document. The converter's own stripping is
+// private; trim() does the same scan, plus a copy.
+void BM_StripDocument(benchmark::State& state, const std::string* html) {
+    reset_peak_rss();
+    std::string markdown = "\n\n" + markdownify::markdownify(*html) + "\n\n";
+
+    std::size_t before = allocation_count.load();
+    for (auto _ : state) {
+        std::string stripped = markdownify::trim(markdown);
+        benchmark::DoNotOptimize(stripped.data());
+    }
+    report(state, markdown.size(), 1, before);
+}
+
+// Everything, the way a long-running worker converts: one session, reused.
+void BM_Convert(benchmark::State& state, const std::string* html) {
+    reset_peak_rss();
+    markdownify::ConversionSession session;
+    session.convert(*html);
+    markdownify::HtmlDocument doc;
+    markdownify::HtmlParser(doc).parse_in_place(*html);
+
+    std::size_t before = allocation_count.load();
+    for (auto _ : state) {
+        std::string_view markdown = session.convert(*html);
+        benchmark::DoNotOptimize(markdown.data());
+    }
+    report(state, html->size(), doc.node_count(), before);
+}
+
+// The same through markdownify(), which sets everything up per call.
+void BM_ConvertOneShot(benchmark::State& state, const std::string* html) {
+    reset_peak_rss();
+    markdownify::HtmlDocument doc;
+    markdownify::HtmlParser(doc).parse_in_place(*html);
+
+    std::size_t before = allocation_count.load();
+    for (auto _ : state) {
+        std::string markdown = markdownify::markdownify(*html);
+        benchmark::DoNotOptimize(markdown.data());
+    }
+    report(state, html->size(), doc.node_count(), before);
+}
+
+}
+
+int main(int argc, char** argv) {
+    using Stage = void (*)(benchmark::State&, const std::string*);
+    const std::pair<const char*, Stage> stages[] = {
+        {"Parse", BM_Parse},
+        {"Walk", BM_Walk},
+        {"Escape", BM_Escape},
+        {"StripDocument", BM_StripDocument},
+        {"Convert", BM_Convert},
+        {"ConvertOneShot", BM_ConvertOneShot},
+    };
+
+    std::vector<std::string> corpora;
+    corpora.reserve(std::size(kCorpora));
+    for (const Corpus& corpus : kCorpora) {
+        corpora.push_back(corpus.make());
+    }
+
+    for (const auto& stage : stages) {
+        for (std::size_t i = 0; i < corpora.size(); ++i) {
+            std::string name = std::string("BM_") + stage.first + "/" + kCorpora[i].name;
+            benchmark::RegisterBenchmark(name.c_str(), stage.second, &corpora[i])
+                ->Unit(benchmark::kMicrosecond);
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <markdownify/text_utils.hpp>
+#include <benchmark/benchmark.h>
+#include <regex>
+#include <string>
+
+namespace {
+
+// Prose with runs of spaces and tabs, as found in indented HTML source.
+std::string make_prose(std::size_t size) {
+    static const char* const pieces[] = {"word ", "  ", "\t", "text\n", "    indented ", "x"};
+    std::string text;
+    for (std::size_t i = 0; text.size() < size; ++i) {
+        text += pieces[i % 6];
+    }
+    text.resize(size);
+    return text;
+}
+
+// Code block whose lines end in blank space: the worst case for [ \n]*$.
+std::string make_code(std::size_t size) {
+    std::string text = "\n  \n";
+    while (text.size() < size) {
+        text += "    int value = 42;   \n  \n";
+    }
+    text.resize(size);
+    return text + "  \n\n";
+}
+
+// Identifiers full of underscores: the quadratic case for replace-in-place.
+std::string make_identifiers(std::size_t size) {
+    std::string text;
+    while (text.size() < size) {
+        text += "some_long_identifier_name * 2 ";
+    }
+    text.resize(size);
+    return text;
+}
+
+void BM_CollapseWhitespace(benchmark::State& state) {
+    std::string text = make_prose(state.range(0));
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        markdownify::collapse_whitespace(text, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_CollapseWhitespace)->RangeMultiplier(4)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+
+void BM_StripPre(benchmark::State& state) {
+    std::string text = make_code(state.range(0));
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        markdownify::strip_pre(text, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_StripPre)->RangeMultiplier(4)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+
+void BM_Strip1Pre(benchmark::State& state) {
+    std::string text = make_code(state.range(0));
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        markdownify::strip1_pre(text, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_Strip1Pre)->RangeMultiplier(4)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+
+// Nothing to escape: should run at close to memcpy speed.
+void BM_EscapeMarkdownClean(benchmark::State& state) {
+    std::string text(state.range(0), 'a');
+    for (std::size_t i = 7; i < text.size(); i += 8) {
+        text[i] = ' ';
+    }
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        markdownify::escape_markdown(text, true, true, true, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_EscapeMarkdownClean)->RangeMultiplier(4)->Range(1 << 6, 1 << 22)->Complexity(benchmark::oN);
+
+void BM_EscapeMarkdownDense(benchmark::State& state) {
+    std::string text = make_identifiers(state.range(0));
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        markdownify::escape_markdown(text, true, true, true, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_EscapeMarkdownDense)->RangeMultiplier(4)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+
+// The std::regex formulation the scanners replaced, for comparison.
+void BM_StripPreRegex(benchmark::State& state) {
+    static const std::regex lstrip(R"(^[ \n]*\n)");
+    static const std::regex rstrip(R"([ \n]*$)");
+    std::string text = make_code(state.range(0));
+    for (auto _ : state) {
+        std::string out = std::regex_replace(std::regex_replace(text, lstrip, ""), rstrip, "");
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_StripPreRegex)->RangeMultiplier(4)->Range(1 << 10, 1 << 14)->Complexity();
+
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace markdownify {
+
+// Bump allocator for trivially destructible objects. reset() rewinds the
+// cursor but keeps every block, so a reused arena stops allocating once it
+// has seen its largest document.
+template <typename T, std::size_t BlockSize = 256>
+class ObjectArena {
+public:
+    T* allocate(std::size_t count = 1) {
+        while (block_ < blocks_.size()) {
+            Block& block = blocks_[block_];
+            if (used_ + count <= block.size) {
+                T* result = block.data.get() + used_;
+                used_ += count;
+                std::fill(result, result + count, T{});
+                return result;
+            }
+            ++block_;
+            used_ = 0;
+        }
+
+        std::size_t size = count > BlockSize ? count : BlockSize;
+        blocks_.push_back(Block{std::make_unique<T[]>(size), size});
+        block_ = blocks_.size() - 1;
+        used_ = count;
+        return blocks_.back().data.get();
+    }
+
+    void reset() {
+        block_ = 0;
+        used_ = 0;
+    }
+
+    std::size_t block_count() const { return blocks_.size(); }
+
+private:
+    struct Block {
+        std::unique_ptr<T[]> data;
+        std::size_t size;
+    };
+
+    std::vector<Block> blocks_;
+    std::size_t block_ = 0;
+    std::size_t used_ = 0;
+};
+
+class StringArena {
+public:
+    std::string_view store(std::string_view text) {
+        if (text.empty()) {
+            return std::string_view();
+        }
+        char* dest = chars_.allocate(text.size());
+        std::memcpy(dest, text.data(), text.size());
+        return std::string_view(dest, text.size());
+    }
+
+    void reset() { chars_.reset(); }
+
+    std::size_t block_count() const { return chars_.block_count(); }
+
+private:
+    ObjectArena<char, 4096> chars_;
+};
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "markdownify/options.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace markdownify {
+
+// convert_batch runs at most this many threads per hardware thread.
+constexpr unsigned kMaxThreadsPerCore = 4;
+
+struct BatchResult {
+    std::string markdown;
+
+    // False when converting this input threw, e.g. from a throwing
+    // code_language_callback or std::bad_alloc; error holds what().
+    bool ok = true;
+    std::string error;
+};
+
+// Converts independent documents in parallel and returns one result per
+// input, in input order. threads == 0 uses every hardware thread, and
+// threads is capped at four per hardware thread; the calling thread is one
+// of the workers.
+//
+// Work runs on a process-wide pool whose threads are kept between calls.
+// Concurrent calls share it and run one after another.
+// Workers share one MarkdownConverter, each with its own ConversionSession,
+// so options.code_language_callback must be safe to call concurrently.
+std::vector<BatchResult> convert_batch(const std::string_view* inputs, std::size_t count,
+                                       const Options& options = Options(),
+                                       unsigned threads = 0);
+
+std::vector<BatchResult> convert_batch(const std::vector<std::string_view>& inputs,
+                                       const Options& options = Options(),
+                                       unsigned threads = 0);
+
+}
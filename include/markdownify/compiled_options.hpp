@@ -0,0 +1,71 @@
+#pragma once
+
+#include "markdownify/html_parser.hpp"
+#include "markdownify/options.hpp"
+#include "markdownify/tags.hpp"
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace markdownify {
+
+// Options checked once and turned into the form the converter looks them up
+// in: tag lists become tables over TagId, so deciding what becomes of an
+// element is a single lookup. Immutable once built, so any number of
+// converters and threads may share one.
+//
+// Building normalizes the options:
+// - tag names are lowercased, as the parser lowercases element names.
+// - empty bullets are replaced with the default "*", "+", "-".
+// - a negative max_depth means no limit, like 0.
+class CompiledOptions {
+public:
+    explicit CompiledOptions(const Options& options = Options());
+
+    // The normalized options.
+    const Options& options() const { return options_; }
+
+    // What becomes of elements with this tag or name: the action in
+    // tag_actions, else SKIP for script and style and for the tags that
+    // Options::should_convert_tag rejects, else CONVERT.
+    TagAction action(TagId tag) const { return actions_[tag_index(tag)]; }
+    TagAction action(std::string_view name) const;
+    TagAction action(const HtmlNode* element) const {
+        return element->tag != TagId::UNKNOWN ? action(element->tag) : action(element->name);
+    }
+
+    bool converts(TagId tag) const { return action(tag) == TagAction::CONVERT; }
+    bool converts(std::string_view name) const { return action(name) == TagAction::CONVERT; }
+    bool converts(const HtmlNode* element) const {
+        return action(element) == TagAction::CONVERT;
+    }
+
+    // Whether images directly inside element keep their Markdown form where
+    // only their alt text would be written, per keep_inline_images_in.
+    bool keeps_inline_images(const HtmlNode* element) const;
+
+private:
+    friend class MarkdownConverter;
+
+    Options options_;
+
+    std::array<TagAction, kTagCount> actions_{};
+    std::bitset<kTagCount> keep_images_in_;
+
+    // Names outside TagId: their tag_actions, then whether they are
+    // converted unless listed in unknown_exceptions_, and the listed ones.
+    // All lists are sorted.
+    std::vector<std::pair<std::string, TagAction>> unknown_actions_;
+    bool converts_unknown_ = true;
+    std::vector<std::string> unknown_exceptions_;
+    std::vector<std::string> unknown_keep_images_in_;
+
+    // 128-bit hash of options_, low half first; equal for equal options.
+    std::uint64_t fingerprint_[2];
+};
+
+}
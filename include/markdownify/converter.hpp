@@ -1,91 +1,315 @@
 #pragma once
 
+#include "markdownify/compiled_options.hpp"
 #include "markdownify/options.hpp"
+#include "markdownify/result_cache.hpp"
+#include "markdownify/stats.hpp"
+#include "markdownify/subtree_cache.hpp"
 #include "markdownify/text_utils.hpp"
-#include <tinyxml2.h>
+#include "markdownify/html_parser.hpp"
+#include "markdownify/writer.hpp"
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
 #include <string>
-#include <unordered_set>
 #include <memory>
+#include <utility>
+#include <optional>
+#include <string_view>
+#include <vector>
 
 namespace markdownify {
 
+namespace detail {
+class SubtreeMemo;
+class TableBuilder;
+}
+
+// What the ancestors of an element imply for its conversion. Each open
+// element keeps its own copy, so nothing is allocated or undone on the way
+// out.
+struct ParentContext {
+    // Known tags among the ancestors.
+    std::bitset<kTagCount> tags;
+
+    // Inside a heading or table cell: images render as their alt text.
+    bool inline_only = false;
+
+    // Inside pre, code, kbd or samp: text is written unescaped.
+    bool no_format = false;
+
+    // Number of enclosing ol and ul elements.
+    int list_depth = 0;
+
+    // Next item number of the innermost enclosing ol. The counter lives in
+    // the walk frame of that ol.
+    int* list_counter = nullptr;
+
+    // Cells of the innermost enclosing table. The builder belongs to the
+    // walk, like the frames.
+    detail::TableBuilder* table = nullptr;
+
+    // Timers to update, when the caller asked for statistics.
+    ConversionStats* stats = nullptr;
+
+    // Subtrees to reuse and store, when converting with a SubtreeCache.
+    detail::SubtreeMemo* memo = nullptr;
+
+    bool has(TagId tag) const { return tags[tag_index(tag)]; }
+};
+
+// Converts parsed HTML with a fixed set of options. All state of a
+// conversion belongs to the call, so one converter may be shared by any
+// number of threads converting at the same time.
 class MarkdownConverter {
 public:
     explicit MarkdownConverter(const Options& options = Options());
 
-    std::string convert(const std::string& html);
+    // Shares options compiled once with other converters.
+    explicit MarkdownConverter(std::shared_ptr<const CompiledOptions> options);
+
+    const std::shared_ptr<const CompiledOptions>& compiled_options() const { return compiled_; }
+
+    std::string convert(std::string_view html) const;
+
+    // Also fills stats. Only this overload pays for the measuring.
+    std::string convert(std::string_view html, ConversionStats& stats) const;
 
-    std::string convert_soup(tinyxml2::XMLDocument& doc);
+    // Reuses the Markdown of the elements that are unchanged since the
+    // document last converted with cache, and keeps this document's for the
+    // next call.
+    std::string convert(std::string_view html, SubtreeCache& cache) const;
+
+    // Returns the Markdown stored in cache for html and these options, or
+    // converts html and stores the result.
+    std::string convert(std::string_view html, ResultCache& cache) const;
+
+    // Converts the file at path, which is memory-mapped and parsed in place.
+    // Returns nullopt if the file cannot be read.
+    std::optional<std::string> convert_file(const std::string& path) const;
+
+    std::string convert_soup(const HtmlDocument& doc) const;
+
+    // Receives the Markdown of a document in order, in pieces.
+    using Sink = std::function<void(std::string_view chunk)>;
+
+    // Pass the Markdown to sink as it is converted rather than returning it:
+    // the output is held only until a run of top-level blocks (counting the
+    // blocks inside transparent containers) fills a chunk. The pieces
+    // concatenate to the string the overloads above return.
+    void convert(std::string_view html, const Sink& sink) const;
+    void convert_soup(const HtmlDocument& doc, const Sink& sink) const;
+
+    // Write the Markdown to out, or to the file descriptor fd. Return false
+    // if writing failed; nothing is written after a failed write.
+    bool convert(std::string_view html, std::ostream& out) const;
+    bool convert_to_fd(std::string_view html, int fd) const;
+
+    // Writes the Markdown of an element: children is the Markdown of its
+    // children, converted as usual, and context what its ancestors imply.
+    // children lives in out.scratch(), which the handler must leave alone.
+    // With a SubtreeCache or ResultCache the output of equal elements is
+    // reused, so it should depend on nothing else.
+    using CustomHandler = std::function<void(const HtmlNode& element, std::string_view children,
+                                             const ParentContext& context, MarkdownWriter& out)>;
+
+    // Converts elements named tag with handler, in place of the built-in
+    // conversion or an earlier handler. A td or th handler writes the cell's
+    // content; a table handler gets its rows written inline. Returns false
+    // and registers nothing for an empty name or handler, and for tr, thead,
+    // tbody and tfoot, which only exist as part of their table. Elements
+    // that Options::tag_actions skips or unwraps never reach a handler. Not
+    // thread-safe: register before the converter is shared.
+    bool set_handler(std::string_view tag, CustomHandler handler);
 
 private:
-    Options options_;
-    int list_depth_ = 0;
-    std::vector<int> list_counters_;
-
-    std::string process_element(tinyxml2::XMLNode* node,
-                                const std::unordered_set<std::string>& parent_tags);
-
-    std::string process_tag(tinyxml2::XMLElement* element,
-                           const std::unordered_set<std::string>& parent_tags);
-
-    std::string process_text(tinyxml2::XMLText* text,
-                            const std::unordered_set<std::string>& parent_tags);
-
-    std::string get_tag_name(tinyxml2::XMLElement* element);
-
-    bool should_remove_whitespace_inside(const std::string& tag_name);
-    bool should_remove_whitespace_outside(const std::string& tag_name);
-
-    std::string convert_a(tinyxml2::XMLElement* el, const std::string& text,
-                         const std::unordered_set<std::string>& parent_tags);
-    std::string convert_blockquote(tinyxml2::XMLElement* el, const std::string& text,
-                                   const std::unordered_set<std::string>& parent_tags);
-    std::string convert_br(tinyxml2::XMLElement* el, const std::string& text,
-                          const std::unordered_set<std::string>& parent_tags);
-    std::string convert_code(tinyxml2::XMLElement* el, const std::string& text,
-                            const std::unordered_set<std::string>& parent_tags);
-    std::string convert_em(tinyxml2::XMLElement* el, const std::string& text,
-                          const std::unordered_set<std::string>& parent_tags);
-    std::string convert_strong(tinyxml2::XMLElement* el, const std::string& text,
-                              const std::unordered_set<std::string>& parent_tags);
-    std::string convert_b(tinyxml2::XMLElement* el, const std::string& text,
-                         const std::unordered_set<std::string>& parent_tags);
-    std::string convert_i(tinyxml2::XMLElement* el, const std::string& text,
-                         const std::unordered_set<std::string>& parent_tags);
-    std::string convert_del(tinyxml2::XMLElement* el, const std::string& text,
-                           const std::unordered_set<std::string>& parent_tags);
-    std::string convert_h(tinyxml2::XMLElement* el, const std::string& text,
-                         const std::unordered_set<std::string>& parent_tags, int level);
-    std::string convert_hr(tinyxml2::XMLElement* el, const std::string& text,
-                          const std::unordered_set<std::string>& parent_tags);
-    std::string convert_img(tinyxml2::XMLElement* el, const std::string& text,
-                           const std::unordered_set<std::string>& parent_tags);
-    std::string convert_li(tinyxml2::XMLElement* el, const std::string& text,
-                          const std::unordered_set<std::string>& parent_tags);
-    std::string convert_ol(tinyxml2::XMLElement* el, const std::string& text,
-                          const std::unordered_set<std::string>& parent_tags);
-    std::string convert_ul(tinyxml2::XMLElement* el, const std::string& text,
-                          const std::unordered_set<std::string>& parent_tags);
-    std::string convert_p(tinyxml2::XMLElement* el, const std::string& text,
-                         const std::unordered_set<std::string>& parent_tags);
-    std::string convert_pre(tinyxml2::XMLElement* el, const std::string& text,
-                           const std::unordered_set<std::string>& parent_tags);
-    std::string convert_table(tinyxml2::XMLElement* el, const std::string& text,
-                             const std::unordered_set<std::string>& parent_tags);
-    std::string convert_tr(tinyxml2::XMLElement* el, const std::string& text,
-                          const std::unordered_set<std::string>& parent_tags);
-    std::string convert_td(tinyxml2::XMLElement* el, const std::string& text,
-                          const std::unordered_set<std::string>& parent_tags);
-    std::string convert_th(tinyxml2::XMLElement* el, const std::string& text,
-                          const std::unordered_set<std::string>& parent_tags);
-
-    std::string escape(const std::string& text,
-                      const std::unordered_set<std::string>& parent_tags);
-
-    std::string inline_markup(const std::string& markup_prefix, const std::string& text,
-                             const std::unordered_set<std::string>& parent_tags);
-
-    std::string strip_document(const std::string& text);
+    friend class ConversionSession;
+    friend class StreamingConverter;
+
+    struct Frame;
+
+    // Applies strip_document to Markdown passed on in pieces: leading
+    // whitespace is dropped until the first content, and trailing whitespace
+    // is held back until more content follows it.
+    class StripBoundary {
+    public:
+        explicit StripBoundary(StripMode mode) : mode_(mode) {}
+
+        // Passes what is certain to remain of markdown to sink.
+        void push(std::string_view markdown, const Sink& sink);
+        void reset();
+
+    private:
+        StripMode mode_;
+        std::string held_;
+        bool started_ = false;
+    };
+
+    using OpenStep = bool (MarkdownConverter::*)(Frame&, const ParentContext&,
+                                                 MarkdownWriter&) const;
+    using CloseStep = void (MarkdownConverter::*)(Frame&, const ParentContext&,
+                                                  MarkdownWriter&) const;
+
+    // Either step may be null. An open step returning false ends the
+    // element there: its children and close step are skipped.
+    struct TagHandler {
+        OpenStep open;
+        CloseStep close;
+    };
+
+    // An element whose children are being converted. Its handler opens it
+    // before the children and closes it after them; the positions and
+    // counter the two steps share are kept here.
+    struct Frame {
+        const HtmlNode* element = nullptr;
+        const HtmlNode* next_child = nullptr;
+        // The element's own context, owned by the frame below or the caller.
+        const ParentContext* context = nullptr;
+        ParentContext children;
+        CloseStep close = nullptr;
+        std::size_t start = 0;
+        std::size_t body = 0;
+        std::size_t depth = 0;
+        int list_counter = 1;
+        // The Markdown goes into the context's memo once closed.
+        bool memoize = false;
+    };
+
+    // The walk's stack of open elements, and a table builder for each open
+    // table among them. Frames are allocated in blocks that are kept when
+    // popped, so a frame never moves (list_counter pointers into it stay
+    // valid). Builders are kept as well, so a reused stack stops allocating
+    // once it has seen documents as deep and tables as large as the next.
+    class FrameStack {
+    public:
+        FrameStack();
+        ~FrameStack();
+
+        bool empty() const { return size_ == 0; }
+        std::size_t size() const { return size_; }
+        Frame& back() { return at(size_ - 1); }
+        void pop_back() { --size_; }
+        Frame& push_back();
+
+        // Returns a cleared builder.
+        detail::TableBuilder& push_table();
+        void pop_table() { --table_count_; }
+
+    private:
+        static constexpr std::size_t kBlockSize = 32;
+        std::vector<std::unique_ptr<Frame[]>> blocks_;
+        std::size_t size_ = 0;
+        std::vector<std::unique_ptr<detail::TableBuilder>> tables_;
+        std::size_t table_count_ = 0;
+
+        Frame& at(std::size_t i) { return blocks_[i / kBlockSize][i % kBlockSize]; }
+    };
+
+    std::shared_ptr<const CompiledOptions> compiled_;
+
+    const Options& options() const { return compiled_->options(); }
+
+    // Indexed by TagId. Unknown tags and tags without a handler write their
+    // children unchanged.
+    std::array<TagHandler, kTagCount> handlers_{};
+
+    // Registered with set_handler, sorted by name, and the index plus one
+    // of each known tag's handler.
+    std::vector<std::pair<std::string, CustomHandler>> custom_handlers_;
+    std::array<std::uint16_t, kTagCount> custom_index_{};
+
+    // Changes with every set_handler, so that cached Markdown of other
+    // handlers is not reused. 0 without handlers.
+    std::uint64_t handlers_version_ = 0;
+
+    // Writes the stripped Markdown of doc into out, which must be empty.
+    void convert_into(const HtmlDocument& doc, MarkdownWriter& out, FrameStack& frames,
+                      ConversionStats* stats = nullptr,
+                      detail::SubtreeMemo* memo = nullptr) const;
+
+    // Converts the children of doc's root one top-level block at a time,
+    // passing out to sink whenever it fills a chunk.
+    void convert_chunked(const HtmlDocument& doc, MarkdownWriter& out, FrameStack& frames,
+                         const Sink& sink) const;
+
+    // Parses html into doc, which must be clear, and converts it into out
+    // while filling stats.
+    void convert_measured(std::string_view html, HtmlDocument& doc, HtmlParser& parser,
+                          MarkdownWriter& out, FrameStack& frames,
+                          ConversionStats& stats) const;
+
+    // Converts node and everything below it, with context as the context of
+    // node itself. Iterative: the depth of the document is bounded by the
+    // heap, not by the thread's stack.
+    void walk(const HtmlNode* node, const ParentContext& context, FrameStack& frames,
+              MarkdownWriter& out) const;
+
+    // Opens element on top of frames, or converts it completely when it has
+    // no children to walk.
+    void enter(const HtmlNode* element, const ParentContext& context, std::size_t depth,
+               FrameStack& frames, MarkdownWriter& out) const;
+
+    // Writes the text below element as if its tags were absent. Used past
+    // Options::max_depth.
+    void flatten(const HtmlNode* element, const ParentContext& context,
+                 MarkdownWriter& out) const;
+
+    void process_text(const HtmlNode* text, const ParentContext& context,
+                      MarkdownWriter& out) const;
+
+    // Fills handlers_. Handlers that depend on an option are templates with
+    // one instantiation per value, and the table holds the ones matching
+    // options(), so they do not look at the option while converting.
+    void build_handlers();
+
+    bool should_remove_whitespace_inside(TagId tag) const;
+    bool should_remove_whitespace_outside(TagId tag) const;
+
+    bool is_transparent(TagId tag) const;
+
+    bool open_a(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    void close_a(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    bool open_blockquote(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    void close_blockquote(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    template <NewlineStyle Style>
+    bool open_br(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    bool open_code(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    void close_code(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    template <char Symbol, std::size_t Count>
+    bool open_inline(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    template <char Symbol, std::size_t Count>
+    void close_inline(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    template <HeadingStyle Style, int Level>
+    bool open_h(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    template <HeadingStyle Style, int Level>
+    void close_h(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    bool open_hr(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    bool open_img(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    void close_li(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    bool open_list(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    void close_list(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    bool open_p(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    void close_p(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    bool open_pre(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    void close_pre(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    bool open_sub_sup(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    void close_sub_sup(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    std::string element_to_html(const HtmlNode* element) const;
+
+    bool open_table(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    void close_table(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    bool open_tr(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    void close_tr(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+    void close_cell(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+
+    void close_custom(Frame& frame, const ParentContext& context, MarkdownWriter& out) const;
+
+    void escape(std::string_view text, const ParentContext& context,
+                MarkdownWriter& out) const;
+
+    void strip_document(std::string& text) const;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,213 @@
+#pragma once
+
+#include "markdownify/arena.hpp"
+#include "markdownify/tags.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace markdownify {
+
+enum class HtmlNodeType {
+    DOCUMENT,
+    ELEMENT,
+    TEXT
+};
+
+struct HtmlAttribute {
+    std::string_view name;
+    std::string_view value;
+};
+
+struct HtmlNode {
+    HtmlNodeType type = HtmlNodeType::TEXT;
+
+    // Lowercased tag name for elements, empty otherwise.
+    std::string_view name;
+
+    // Interned name, UNKNOWN for text nodes and unlisted elements.
+    TagId tag = TagId::UNKNOWN;
+
+    // Decoded character data for text nodes, empty otherwise.
+    std::string_view value;
+
+    const HtmlAttribute* attributes = nullptr;
+    std::size_t attribute_count = 0;
+
+    HtmlNode* parent = nullptr;
+    HtmlNode* first_child = nullptr;
+    HtmlNode* last_child = nullptr;
+    HtmlNode* prev_sibling = nullptr;
+    HtmlNode* next_sibling = nullptr;
+
+    bool is_element() const { return type == HtmlNodeType::ELEMENT; }
+    bool is_text() const { return type == HtmlNodeType::TEXT; }
+
+    const HtmlAttribute* find_attribute(std::string_view attr_name) const;
+
+    std::string_view attribute(std::string_view attr_name) const {
+        const HtmlAttribute* attr = find_attribute(attr_name);
+        return attr ? attr->value : std::string_view();
+    }
+
+    const HtmlNode* first_child_element(std::string_view tag = std::string_view()) const;
+    const HtmlNode* next_sibling_element(std::string_view tag = std::string_view()) const;
+};
+
+class HtmlDocument {
+public:
+    HtmlDocument();
+
+    HtmlDocument(const HtmlDocument&) = delete;
+    HtmlDocument& operator=(const HtmlDocument&) = delete;
+
+    const HtmlNode* root() const { return root_; }
+    HtmlNode* root() { return root_; }
+
+    void clear();
+
+    HtmlNode* create_element(std::string_view name);
+    HtmlNode* create_text(std::string_view value);
+    HtmlAttribute* create_attributes(std::size_t count);
+    std::string_view store(std::string_view text) { return strings_.store(text); }
+
+    static void append_child(HtmlNode* parent, HtmlNode* child);
+
+    std::size_t node_count() const { return node_count_; }
+
+    // Memory blocks held by the arenas.
+    std::size_t block_count() const {
+        return nodes_.block_count() + attributes_.block_count() + strings_.block_count();
+    }
+
+private:
+    ObjectArena<HtmlNode> nodes_;
+    ObjectArena<HtmlAttribute> attributes_;
+    StringArena strings_;
+    HtmlNode* root_ = nullptr;
+    std::size_t node_count_ = 0;
+};
+
+// Error-tolerant single-pass HTML parser. Every input produces a tree:
+// void elements never need closing, optional end tags (p, li, td, ...) are
+// implied, stray end tags are ignored and unclosed elements are closed at
+// the end of input. script/style/title/textarea contents are raw text.
+//
+// Input can be given at once with parse() or incrementally with feed() and
+// finish(); both build the same tree. Between feed() calls the parser only
+// keeps the unfinished tail of the input (an incomplete tag, or text that
+// may end in a character reference).
+class HtmlParser {
+public:
+    explicit HtmlParser(HtmlDocument& doc);
+
+    void parse(std::string_view html);
+
+    // Like parse(), but text and attribute values that need no decoding
+    // point into html instead of being copied, so html must outlive the
+    // document's use.
+    void parse_in_place(std::string_view html);
+
+    void feed(std::string_view chunk);
+    void finish();
+
+    void reset();
+
+    // Open elements, outermost first; index 0 is the document root.
+    const std::vector<HtmlNode*>& open_elements() const { return open_elements_; }
+
+    // Replaces the open element stack after the caller rebuilt the document.
+    void rebase(HtmlNode* const* open_elements, std::size_t count);
+
+private:
+    static constexpr std::size_t kIncomplete = static_cast<std::size_t>(-1);
+
+    // Element kinds that bound the search for an open element to close.
+    enum class Scope : std::uint8_t {
+        DEFAULT,
+        BUTTON,
+        LIST_ITEM,
+        DEFINITION,
+        TABLE,
+        DOCUMENT,
+        COUNT
+    };
+
+    static constexpr std::size_t kScopeCount = static_cast<std::size_t>(Scope::COUNT);
+
+    // Kept alongside each open element so scope checks need no stack walk:
+    // the index of the next open element below with the same name, and of
+    // the nearest boundary of each scope at or below this one (0 if none).
+    struct OpenLink {
+        std::uint32_t previous = 0;
+        std::array<std::uint32_t, kScopeCount> boundaries = {};
+    };
+
+    struct AttributeSpan {
+        std::size_t name_offset = 0;
+        std::size_t name_length = 0;
+        std::size_t value_offset = 0;
+        std::size_t value_length = 0;
+        std::string_view borrowed_value;
+    };
+
+    HtmlDocument& doc_;
+    std::vector<HtmlNode*> open_elements_;
+    std::vector<OpenLink> open_links_;
+    // Topmost open element per name, 0 if none.
+    std::array<std::uint32_t, kTagCount> last_open_ = {};
+    std::unordered_map<std::string_view, std::uint32_t> last_open_unknown_;
+    std::vector<HtmlAttribute> attributes_;
+    std::vector<AttributeSpan> attribute_spans_;
+    std::string attribute_text_;
+    std::string name_buffer_;
+    std::string tag_buffer_;
+    std::string text_buffer_;
+    std::string_view borrowed_text_;
+    std::string pending_;
+    const char* raw_text_tag_ = nullptr;
+    bool raw_text_decode_ = false;
+    bool borrow_input_ = false;
+
+    HtmlNode* current_node() { return open_elements_.back(); }
+
+    std::size_t consume(std::string_view html, bool final);
+    std::size_t parse_markup(std::string_view html, std::size_t lt, bool final);
+    std::size_t parse_start_tag(std::string_view html, std::size_t pos, bool final);
+    std::size_t parse_end_tag(std::string_view html, std::size_t pos, bool final);
+    std::size_t parse_raw_text(std::string_view html, std::size_t pos, bool final);
+    std::size_t skip_past(std::string_view html, std::size_t pos,
+                          std::string_view terminator, bool final);
+    static std::size_t safe_text_end(std::string_view input, std::size_t pos,
+                                     std::size_t end);
+
+    void add_text(std::string_view text, bool decode);
+    void unborrow_text();
+    void flush_text();
+    void insert_element(std::string_view name, bool self_closing);
+    void close_element(std::string_view name);
+    void close_implied_for(TagId tag, std::string_view name);
+    bool close_in_scope(std::uint32_t index, Scope scope);
+
+    static unsigned boundary_mask(TagId tag, std::string_view name);
+    std::uint32_t& last_open_slot(const HtmlNode* node);
+    std::uint32_t last_open(TagId tag, std::string_view name = std::string_view()) const;
+    void push_open(HtmlNode* element);
+    void pop_open_to(std::size_t size);
+};
+
+// Appends text to out with character references decoded and "\r\n" and
+// "\r" turned into "\n". Named references cover all of HTML5, including the
+// legacy ones without ';'; in_attribute applies the stricter rules for
+// those in attribute values.
+void decode_entities(std::string_view text, std::string& out, bool in_attribute = false);
+
+bool is_void_element(std::string_view tag);
+
+std::string to_html(const HtmlNode* node);
+
+}
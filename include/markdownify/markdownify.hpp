@@ -1,12 +1,16 @@
 #pragma once
 
+#include "markdownify/batch.hpp"
 #include "markdownify/converter.hpp"
 #include "markdownify/options.hpp"
+#include "markdownify/session.hpp"
+#include "markdownify/streaming.hpp"
 #include <string>
+#include <string_view>
 
 namespace markdownify {
 
-inline std::string markdownify(const std::string& html, const Options& options = Options()) {
+inline std::string markdownify(std::string_view html, const Options& options = Options()) {
     MarkdownConverter converter(options);
     return converter.convert(html);
 }
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <functional>
 
@@ -32,6 +33,16 @@ enum class StripMode {
     STRIP_ONE
 };
 
+// What becomes of an element, decided before its children are visited.
+enum class TagAction {
+    // Written as Markdown, with its children.
+    CONVERT,
+    // Its children are converted as if the tag were absent.
+    UNWRAP,
+    // Dropped with everything inside it.
+    SKIP
+};
+
 struct Options {
     bool autolinks = true;
 
@@ -41,6 +52,8 @@ struct Options {
 
     std::function<std::string(const std::string&)> code_language_callback = nullptr;
 
+    // If set, only elements with these tags (and html, body and div) are
+    // converted, and the rest are skipped with their content.
     std::unordered_set<std::string> convert_tags;
 
     bool default_title = false;
@@ -53,8 +66,13 @@ struct Options {
 
     std::vector<std::string> keep_inline_images_in;
 
+    // Elements nested deeper than this are not converted; only the text
+    // below them is kept. 0 means no limit.
+    int max_depth = 0;
+
     NewlineStyle newline_style = NewlineStyle::SPACES;
 
+    // Elements with these tags are skipped with their content.
     std::unordered_set<std::string> strip_tags;
 
     StripMode strip_document = StripMode::STRIP;
@@ -65,8 +83,17 @@ struct Options {
     std::string sub_symbol = "";
     std::string sup_symbol = "";
 
+    // Actions by tag name, taking precedence over strip_tags and
+    // convert_tags. script and style are skipped unless listed here.
+    std::unordered_map<std::string, TagAction> tag_actions;
+
     bool table_infer_header = false;
 
+    // Pad table cells so that the columns line up in the Markdown source.
+    bool table_align_columns = false;
+
+    bool preserve_html_tables = false;
+
     bool wrap = false;
     int wrap_width = 80;
 
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace markdownify {
+
+namespace detail {
+struct Hash128;
+}
+
+struct ResultCacheStats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+
+    std::size_t entry_count = 0;
+
+    // Stored Markdown plus a fixed overhead per entry, as counted against
+    // the capacity.
+    std::size_t bytes = 0;
+};
+
+// Markdown of recently converted documents, for
+// MarkdownConverter::convert(html, cache). Entries are keyed by a 128-bit
+// hash of the HTML and of the converter's options, so converters with equal
+// options share them; a hit returns the stored Markdown without parsing.
+// Converters with a code_language_callback never share entries, as the
+// callback cannot be compared.
+//
+// A hit also compares the HTML's length and a second, independently seeded
+// hash, so an accidental collision is a miss rather than another document's
+// Markdown. The hashes are fast, not cryptographic: if one cache serves
+// several untrusted sources, one of them could craft a document that
+// collides with another's and be served its Markdown. Give such sources
+// separate caches.
+//
+// The cache is split into shards with a lock each, so threads converting at
+// the same time rarely wait for each other. Each shard holds an equal part
+// of the capacity and evicts its least recently used entries to stay within
+// it. Documents whose Markdown would not fit into a shard are not stored.
+class ResultCache {
+public:
+    // shard_count is rounded up to a power of two.
+    explicit ResultCache(std::size_t capacity_bytes, std::size_t shard_count = 16);
+    ~ResultCache();
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    std::size_t capacity() const { return shard_capacity_ * shards_.size(); }
+
+    // Sums the shards. Taken shard by shard, so the totals may mix in
+    // conversions that finish meanwhile.
+    ResultCacheStats stats() const;
+
+    // Drops all entries. The counters are kept.
+    void clear();
+
+private:
+    friend class MarkdownConverter;
+
+    struct Shard;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t shard_capacity_;
+
+    Shard& shard(const detail::Hash128& key);
+    std::optional<std::string> find(const detail::Hash128& key, std::string_view html);
+    void insert(const detail::Hash128& key, std::string_view html, const std::string& markdown);
+};
+
+}
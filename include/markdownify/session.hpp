@@ -0,0 +1,51 @@
+#pragma once
+
+#include "markdownify/converter.hpp"
+#include "markdownify/html_parser.hpp"
+#include "markdownify/options.hpp"
+#include "markdownify/writer.hpp"
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace markdownify {
+
+// Converts documents one after another, keeping the parse tree storage,
+// parser and walk stacks and output buffer of the previous document instead
+// of freeing them. Once a session has seen its largest document, converting
+// another one does not touch the heap for ordinary markup.
+//
+// A session is meant to be owned by one thread; any number of sessions may
+// share one MarkdownConverter.
+class ConversionSession {
+public:
+    explicit ConversionSession(const Options& options = Options());
+
+    // Converts with converter, which must outlive the session.
+    explicit ConversionSession(const MarkdownConverter& converter);
+
+    ConversionSession(const ConversionSession&) = delete;
+    ConversionSession& operator=(const ConversionSession&) = delete;
+
+    // Returns the Markdown of html. The view points into the session and is
+    // valid until the next call.
+    std::string_view convert(std::string_view html);
+
+    // Also fills stats.
+    std::string_view convert(std::string_view html, ConversionStats& stats);
+
+    // Converts the file at path, memory-mapped and parsed in place. Returns
+    // nullopt if the file cannot be read.
+    std::optional<std::string_view> convert_file(const std::string& path);
+
+private:
+    std::unique_ptr<MarkdownConverter> owned_converter_;
+    const MarkdownConverter* converter_;
+    HtmlDocument doc_;
+    HtmlParser parser_;
+    MarkdownWriter out_;
+    MarkdownConverter::FrameStack frames_;
+};
+
+}
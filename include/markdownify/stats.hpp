@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace markdownify {
+
+// Measurements of one conversion, filled by the convert() overloads that
+// take a ConversionStats. The other overloads measure nothing.
+struct ConversionStats {
+    std::size_t input_bytes = 0;
+    std::size_t output_bytes = 0;
+
+    std::size_t element_count = 0;
+    std::size_t text_node_count = 0;
+
+    // Nesting depth of the deepest node; top-level nodes are at depth 1.
+    std::size_t max_depth = 0;
+
+    // HTML to tree, including entity decoding.
+    std::chrono::nanoseconds parse_time{0};
+
+    // Tree to Markdown. Includes escape_time.
+    std::chrono::nanoseconds walk_time{0};
+
+    // Markdown escaping of text nodes, summed over the walk.
+    std::chrono::nanoseconds escape_time{0};
+
+    // Leading and trailing whitespace removal from the finished document.
+    std::chrono::nanoseconds strip_time{0};
+
+    // Memory blocks the parse tree arenas had to allocate. A reused
+    // ConversionSession reports zero once it has seen a larger document.
+    std::size_t arena_blocks = 0;
+};
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "markdownify/converter.hpp"
+#include "markdownify/html_parser.hpp"
+#include "markdownify/options.hpp"
+#include "markdownify/writer.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace markdownify {
+
+// Push-based converter. feed() parses the next chunk of HTML and returns the
+// Markdown of every top-level block that the chunk completed; finish()
+// returns the remainder. Concatenating all returned pieces gives exactly
+// MarkdownConverter::convert() of the whole input.
+//
+// Blocks directly inside transparent containers (html, body, div, section,
+// ...) count as top-level, and emitted nodes are released, so memory is
+// bounded by the open blocks rather than by the document size.
+class StreamingConverter {
+public:
+    explicit StreamingConverter(const Options& options = Options());
+
+    std::string feed(std::string_view chunk);
+
+    std::string finish();
+
+private:
+    struct Frame {
+        HtmlNode* node;
+        const HtmlNode* last_emitted;
+    };
+
+    struct SavedNode {
+        HtmlNodeType type;
+        std::size_t name_offset;
+        std::size_t name_length;
+        std::size_t attribute_begin;
+        std::size_t attribute_count;
+    };
+
+    struct SavedAttribute {
+        std::size_t name_offset;
+        std::size_t name_length;
+        std::size_t value_offset;
+        std::size_t value_length;
+    };
+
+    MarkdownConverter converter_;
+    HtmlDocument doc_;
+    HtmlParser parser_;
+    std::vector<Frame> frontier_;
+    MarkdownWriter block_;
+    MarkdownConverter::FrameStack frames_;
+    std::string output_;
+    MarkdownConverter::StripBoundary strip_;
+
+    std::string saved_text_;
+    std::vector<SavedNode> saved_nodes_;
+    std::vector<SavedAttribute> saved_attributes_;
+    std::vector<HtmlNode*> rebuilt_;
+
+    void pump(bool final);
+    void finish_frames(std::size_t from);
+    void emit_node(const HtmlNode* node);
+    void emit(std::string_view markdown);
+    bool quiescent() const;
+    void compact();
+    std::size_t save(const HtmlNode* node);
+    HtmlNode* restore(const SavedNode& saved);
+    void reset();
+};
+
+}
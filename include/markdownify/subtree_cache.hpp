@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace markdownify {
+
+namespace detail {
+class SubtreeMemo;
+}
+
+// The Markdown of the elements of the last document converted with
+// MarkdownConverter::convert(html, cache). Converting an edited version of
+// that document reuses it for every element whose markup and surroundings
+// are unchanged, so only the elements on the path from an edit up to the
+// root are converted again. The output is the same as without the cache.
+//
+// A cache is meant to follow the versions of one document through one
+// converter; it is not safe to share between threads.
+class SubtreeCache {
+public:
+    SubtreeCache();
+    ~SubtreeCache();
+
+    SubtreeCache(const SubtreeCache&) = delete;
+    SubtreeCache& operator=(const SubtreeCache&) = delete;
+
+    // Elements of the last conversion taken from the cache, and converted
+    // and added to it.
+    std::size_t reused_count() const;
+    std::size_t stored_count() const;
+
+    // Elements kept for the next conversion.
+    std::size_t size() const;
+
+    void clear();
+
+private:
+    friend class MarkdownConverter;
+
+    std::unique_ptr<detail::SubtreeMemo> memo_;
+};
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace markdownify {
+
+// Interned HTML element names. Elements outside this set are UNKNOWN and
+// are handled by name.
+enum class TagId : std::uint8_t {
+    UNKNOWN,
+    A, ABBR, ADDRESS, AREA, ARTICLE, ASIDE, AUDIO, B, BASE, BDI, BDO, BLOCKQUOTE, BODY, BR,
+    BUTTON, CANVAS, CAPTION, CITE, CODE, COL, COLGROUP, DATA, DATALIST, DD, DEL, DETAILS, DFN,
+    DIALOG, DIV, DL, DT, EM, EMBED, FIELDSET, FIGCAPTION, FIGURE, FOOTER, FORM, H1, H2, H3, H4,
+    H5, H6, HEAD, HEADER, HGROUP, HR, HTML, I, IFRAME, IMG, INPUT, INS, KBD, LABEL, LEGEND, LI,
+    LINK, MAIN, MAP, MARK, MENU, META, METER, NAV, NOSCRIPT, OBJECT, OL, OPTGROUP, OPTION,
+    OUTPUT, P, PARAM, PICTURE, PRE, PROGRESS, Q, RP, RT, RUBY, S, SAMP, SCRIPT, SEARCH,
+    SECTION, SELECT, SLOT, SMALL, SOURCE, SPAN, STRIKE, STRONG, STYLE, SUB, SUMMARY, SUP,
+    TABLE, TBODY, TD, TEMPLATE, TEXTAREA, TFOOT, TH, THEAD, TIME, TITLE, TR, TRACK, U, UL, VAR,
+    VIDEO, WBR,
+    COUNT
+};
+
+constexpr std::size_t kTagCount = static_cast<std::size_t>(TagId::COUNT);
+
+constexpr std::size_t tag_index(TagId id) {
+    return static_cast<std::size_t>(id);
+}
+
+namespace detail {
+
+// Indexed by TagId.
+inline constexpr std::string_view kTagNames[kTagCount] = {
+    "", "a", "abbr", "address", "area", "article", "aside", "audio", "b", "base", "bdi", "bdo",
+    "blockquote", "body", "br", "button", "canvas", "caption", "cite", "code", "col", "colgroup",
+    "data", "datalist", "dd", "del", "details", "dfn", "dialog", "div", "dl", "dt", "em",
+    "embed", "fieldset", "figcaption", "figure", "footer", "form", "h1", "h2", "h3", "h4", "h5",
+    "h6", "head", "header", "hgroup", "hr", "html", "i", "iframe", "img", "input", "ins", "kbd",
+    "label", "legend", "li", "link", "main", "map", "mark", "menu", "meta", "meter", "nav",
+    "noscript", "object", "ol", "optgroup", "option", "output", "p", "param", "picture", "pre",
+    "progress", "q", "rp", "rt", "ruby", "s", "samp", "script", "search", "section", "select",
+    "slot", "small", "source", "span", "strike", "strong", "style", "sub", "summary", "sup",
+    "table", "tbody", "td", "template", "textarea", "tfoot", "th", "thead", "time", "title",
+    "tr", "track", "u", "ul", "var", "video", "wbr"
+};
+
+constexpr std::size_t kMaxTagLength = 10;
+constexpr std::size_t kTagSlots = 2048;
+
+constexpr std::uint32_t tag_hash(std::string_view name, std::uint32_t seed) {
+    std::uint32_t hash = seed;
+    for (char c : name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+struct TagTable {
+    std::uint32_t seed = 0;
+    std::array<TagId, kTagSlots> slots = {};
+};
+
+// Tries seeds until every known name lands in its own slot.
+constexpr TagTable build_tag_table() {
+    for (std::uint32_t seed = 1; seed < 1000; ++seed) {
+        TagTable table;
+        table.seed = seed;
+        bool collided = false;
+        for (std::size_t id = 1; id < kTagCount && !collided; ++id) {
+            TagId& slot = table.slots[tag_hash(kTagNames[id], seed) % kTagSlots];
+            collided = slot != TagId::UNKNOWN;
+            slot = static_cast<TagId>(id);
+        }
+        if (!collided) {
+            return table;
+        }
+    }
+    return TagTable();
+}
+
+inline constexpr TagTable kTagTable = build_tag_table();
+static_assert(kTagTable.seed != 0, "no perfect hash seed for the tag set");
+
+}
+
+// Expects a lowercased name, as stored in HtmlNode::name.
+constexpr TagId lookup_tag(std::string_view name) {
+    if (name.empty() || name.size() > detail::kMaxTagLength) {
+        return TagId::UNKNOWN;
+    }
+    TagId id = detail::kTagTable.slots[detail::tag_hash(name, detail::kTagTable.seed) %
+                                       detail::kTagSlots];
+    return detail::kTagNames[tag_index(id)] == name ? id : TagId::UNKNOWN;
+}
+
+constexpr std::string_view tag_name(TagId id) {
+    return detail::kTagNames[tag_index(id)];
+}
+
+}
@@ -1,8 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <tuple>
-#include <regex>
 
 namespace markdownify {
 
@@ -18,9 +19,22 @@ std::string strip_pre(const std::string& text);
 
 std::string strip1_pre(const std::string& text);
 
+// Buffer variants append their result to out.
+void strip_pre(std::string_view text, std::string& out);
+
+void strip1_pre(std::string_view text, std::string& out);
+
+// The part of text that strip_pre and strip1_pre keep.
+std::string_view strip_pre_view(std::string_view text);
+
+std::string_view strip1_pre_view(std::string_view text);
+
 std::string escape_markdown(const std::string& text, bool escape_asterisks,
                            bool escape_underscores, bool escape_misc);
 
+void escape_markdown(std::string_view text, bool escape_asterisks,
+                     bool escape_underscores, bool escape_misc, std::string& out);
+
 std::string underline(const std::string& text, char pad_char);
 
 bool is_whitespace_only(const std::string& text);
@@ -31,26 +45,29 @@ std::string trim_left(const std::string& str);
 
 std::string trim_right(const std::string& str);
 
+// Columns text takes in a terminal, per UTF-8 code point: East Asian wide
+// characters and emoji take 2, combining marks 0. Invalid bytes take 1.
+std::size_t display_width(std::string_view text);
+
+// Wraps text to width columns, as counted by display_width. Breaks only at
+// spaces outside code spans and inline links and images. Hard breaks (two
+// spaces or a backslash before a newline) are kept; other newlines count as
+// spaces. Words wider than width get a line of their own. Does nothing if
+// width <= 0.
 std::string wrap_text(const std::string& text, int width);
 
+void wrap_text(std::string_view text, int width, std::string& out);
+
+// Wraps the part of text from pos on without copying it, as the wrapped
+// text is never longer.
+void wrap_text_in_place(std::string& text, std::size_t pos, int width);
+
 std::string collapse_whitespace(const std::string& text);
 
-std::string normalize_newlines(const std::string& text);
+void collapse_whitespace(std::string_view text, std::string& out);
 
-class RegexPatterns {
-public:
-    static const std::regex& whitespace();
-    static const std::regex& all_whitespace();
-    static const std::regex& newline_whitespace();
-    static const std::regex& pre_lstrip1();
-    static const std::regex& pre_rstrip1();
-    static const std::regex& pre_lstrip();
-    static const std::regex& pre_rstrip();
-    static const std::regex& escape_misc_chars();
-    static const std::regex& escape_misc_dash_sequences();
-    static const std::regex& escape_misc_hashes();
-    static const std::regex& escape_misc_list_items();
-    static const std::regex& backtick_runs();
-};
+// Replaces every run of spaces, tabs and line breaks that holds a line break
+// with a single "\n".
+std::string normalize_newlines(const std::string& text);
 
 }
\ No newline at end of file
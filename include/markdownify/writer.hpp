@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace markdownify {
+
+// Output buffer shared by all handlers of one conversion. Elements append
+// their Markdown directly and remember the size() at which they started;
+// prefixes that depend on the children are patched in afterwards.
+class MarkdownWriter {
+public:
+    std::size_t size() const { return buffer_.size(); }
+
+    void append(std::string_view text) { buffer_.append(text.data(), text.size()); }
+    void append(char c) { buffer_ += c; }
+    void append(std::size_t count, char c) { buffer_.append(count, c); }
+
+    // Output written since pos.
+    std::string_view view(std::size_t pos = 0) const {
+        return std::string_view(buffer_).substr(pos);
+    }
+
+    void truncate(std::size_t pos) { buffer_.resize(pos); }
+
+    // Replaces count bytes at pos with text. Later output only moves when
+    // the sizes differ, so callers reserve a placeholder of the likely size.
+    void replace(std::size_t pos, std::size_t count, std::string_view text);
+
+    void insert(std::size_t pos, std::string_view text) { replace(pos, 0, text); }
+
+    void erase(std::size_t pos, std::size_t count) { buffer_.erase(pos, count); }
+
+    // Rewrites the output since pos line by line, as "first" + line + "\n"
+    // for the first line and "rest" + line + "\n" for the others.
+    void prefix_lines(std::size_t pos, std::string_view first, std::string_view rest);
+
+    void clear() { buffer_.clear(); }
+
+    std::string& str() { return buffer_; }
+
+    // Spare buffer for text that is transformed before being appended, kept
+    // here so that its capacity is reused across the conversion.
+    std::string& scratch() { return scratch_; }
+
+private:
+    std::string buffer_;
+    std::string scratch_;
+};
+
+}
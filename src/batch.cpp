@@ -0,0 +1,137 @@
+#include "markdownify/batch.hpp"
+#include "markdownify/converter.hpp"
+#include "markdownify/session.hpp"
+#include "worker_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <thread>
+
+namespace markdownify {
+
+namespace {
+
+// Unclaimed inputs of one worker as [begin, end), packed into one word so
+// that the owner and thieves can update it with a single CAS.
+struct alignas(64) WorkRange {
+    std::atomic<std::uint64_t> bounds{0};
+};
+
+constexpr std::uint64_t pack(std::uint32_t begin, std::uint32_t end) {
+    return (static_cast<std::uint64_t>(begin) << 32) | end;
+}
+
+constexpr std::uint32_t begin_of(std::uint64_t bounds) {
+    return static_cast<std::uint32_t>(bounds >> 32);
+}
+
+constexpr std::uint32_t end_of(std::uint64_t bounds) {
+    return static_cast<std::uint32_t>(bounds);
+}
+
+// The owner takes inputs from the front.
+bool take_front(WorkRange& range, std::uint32_t& index) {
+    std::uint64_t bounds = range.bounds.load(std::memory_order_relaxed);
+    while (begin_of(bounds) < end_of(bounds)) {
+        if (range.bounds.compare_exchange_weak(bounds, pack(begin_of(bounds) + 1, end_of(bounds)),
+                                               std::memory_order_relaxed)) {
+            index = begin_of(bounds);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Thieves take the back half, rounded up.
+bool steal_back(WorkRange& range, std::uint32_t& begin, std::uint32_t& end) {
+    std::uint64_t bounds = range.bounds.load(std::memory_order_relaxed);
+    while (begin_of(bounds) < end_of(bounds)) {
+        std::uint32_t remaining = end_of(bounds) - begin_of(bounds);
+        std::uint32_t split = end_of(bounds) - (remaining + 1) / 2;
+        if (range.bounds.compare_exchange_weak(bounds, pack(begin_of(bounds), split),
+                                               std::memory_order_relaxed)) {
+            begin = split;
+            end = end_of(bounds);
+            return true;
+        }
+    }
+    return false;
+}
+
+void convert_one(ConversionSession& session, std::string_view html, BatchResult& result) {
+    try {
+        result.markdown.assign(session.convert(html));
+    } catch (const std::exception& e) {
+        result.ok = false;
+        result.error = e.what();
+    } catch (...) {
+        result.ok = false;
+        result.error = "unknown exception";
+    }
+}
+
+}
+
+std::vector<BatchResult> convert_batch(const std::string_view* inputs, std::size_t count,
+                                       const Options& options, unsigned threads) {
+    std::vector<BatchResult> results(count);
+    if (count == 0) {
+        return results;
+    }
+
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    if (threads == 0) {
+        threads = hardware;
+    }
+    // The pool keeps its threads for the life of the process.
+    threads = std::min(threads, hardware * kMaxThreadsPerCore);
+    unsigned workers = static_cast<unsigned>(std::min<std::size_t>(threads, count));
+
+    // Indices are packed into 32 bits; larger batches run in slices.
+    constexpr std::size_t kMaxSlice = UINT32_MAX;
+    std::unique_ptr<WorkRange[]> ranges(new WorkRange[workers]);
+    const MarkdownConverter converter(options);
+
+    for (std::size_t offset = 0; offset < count; offset += kMaxSlice) {
+        std::size_t slice = std::min(count - offset, kMaxSlice);
+        for (unsigned w = 0; w < workers; ++w) {
+            ranges[w].bounds.store(pack(static_cast<std::uint32_t>(slice * w / workers),
+                                        static_cast<std::uint32_t>(slice * (w + 1) / workers)),
+                                   std::memory_order_relaxed);
+        }
+
+        detail::WorkerPool::shared().run(workers, [&](unsigned self) {
+            ConversionSession session(converter);
+            std::uint32_t index;
+            for (;;) {
+                while (take_front(ranges[self], index)) {
+                    convert_one(session, inputs[offset + index], results[offset + index]);
+                }
+
+                bool stolen = false;
+                for (unsigned i = 1; i < workers && !stolen; ++i) {
+                    std::uint32_t begin;
+                    std::uint32_t end;
+                    if (steal_back(ranges[(self + i) % workers], begin, end)) {
+                        ranges[self].bounds.store(pack(begin, end), std::memory_order_relaxed);
+                        stolen = true;
+                    }
+                }
+                if (!stolen) {
+                    return;
+                }
+            }
+        });
+    }
+
+    return results;
+}
+
+std::vector<BatchResult> convert_batch(const std::vector<std::string_view>& inputs,
+                                       const Options& options, unsigned threads) {
+    return convert_batch(inputs.data(), inputs.size(), options, threads);
+}
+
+}
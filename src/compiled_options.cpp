@@ -0,0 +1,185 @@
+#include "markdownify/compiled_options.hpp"
+#include "hash.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+
+namespace markdownify {
+
+namespace {
+
+std::string lowercase(std::string name) {
+    for (char& c : name) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return name;
+}
+
+template <typename Names>
+Names lowercase_all(const Names& names) {
+    Names result;
+    for (const std::string& name : names) {
+        if (!name.empty()) {
+            result.insert(result.end(), lowercase(name));
+        }
+    }
+    return result;
+}
+
+// The names that are not TagIds, sorted.
+template <typename Names>
+std::vector<std::string> unknown_names(const Names& names) {
+    std::vector<std::string> unknown;
+    for (const std::string& name : names) {
+        if (lookup_tag(name) == TagId::UNKNOWN) {
+            unknown.push_back(name);
+        }
+    }
+    std::sort(unknown.begin(), unknown.end());
+    return unknown;
+}
+
+bool contains(const std::vector<std::string>& sorted, std::string_view name) {
+    return std::binary_search(sorted.begin(), sorted.end(), name,
+                              [](std::string_view a, std::string_view b) { return a < b; });
+}
+
+void add_strings(detail::Hasher& hasher, const std::vector<std::string>& strings) {
+    hasher.add(static_cast<std::uint64_t>(strings.size()));
+    for (const std::string& s : strings) {
+        hasher.add(s);
+    }
+}
+
+// Sorted first, so that the fingerprint does not depend on the set's order.
+void add_strings(detail::Hasher& hasher, const std::unordered_set<std::string>& set) {
+    std::vector<std::string> strings(set.begin(), set.end());
+    std::sort(strings.begin(), strings.end());
+    add_strings(hasher, strings);
+}
+
+void add_actions(detail::Hasher& hasher,
+                 const std::unordered_map<std::string, TagAction>& actions) {
+    std::vector<std::pair<std::string, TagAction>> sorted(actions.begin(), actions.end());
+    std::sort(sorted.begin(), sorted.end());
+    hasher.add(static_cast<std::uint64_t>(sorted.size()));
+    for (const auto& [name, action] : sorted) {
+        hasher.add(name);
+        hasher.add(static_cast<std::uint64_t>(action));
+    }
+}
+
+// A callback cannot be compared with another, so options with one get a
+// fingerprint of their own.
+detail::Hash128 fingerprint(const Options& options) {
+    static std::atomic<std::uint64_t> callbacks{0};
+
+    detail::Hasher hasher;
+    hasher.add(static_cast<std::uint64_t>(options.autolinks));
+    add_strings(hasher, options.bullets);
+    hasher.add(options.code_language);
+    hasher.add(options.code_language_callback ? ++callbacks : 0);
+    add_strings(hasher, options.convert_tags);
+    hasher.add(static_cast<std::uint64_t>(options.default_title));
+    hasher.add(static_cast<std::uint64_t>(options.escape_asterisks));
+    hasher.add(static_cast<std::uint64_t>(options.escape_underscores));
+    hasher.add(static_cast<std::uint64_t>(options.escape_misc));
+    hasher.add(static_cast<std::uint64_t>(options.heading_style));
+    add_strings(hasher, options.keep_inline_images_in);
+    hasher.add(static_cast<std::uint64_t>(options.max_depth));
+    hasher.add(static_cast<std::uint64_t>(options.newline_style));
+    add_strings(hasher, options.strip_tags);
+    hasher.add(static_cast<std::uint64_t>(options.strip_document));
+    hasher.add(static_cast<std::uint64_t>(options.strip_pre));
+    hasher.add(static_cast<std::uint64_t>(options.strong_em_symbol));
+    hasher.add(options.sub_symbol);
+    hasher.add(options.sup_symbol);
+    add_actions(hasher, options.tag_actions);
+    hasher.add(static_cast<std::uint64_t>(options.table_infer_header));
+    hasher.add(static_cast<std::uint64_t>(options.table_align_columns));
+    hasher.add(static_cast<std::uint64_t>(options.preserve_html_tables));
+    hasher.add(static_cast<std::uint64_t>(options.wrap));
+    hasher.add(static_cast<std::uint64_t>(options.wrap_width));
+    return hasher.finish();
+}
+
+}
+
+CompiledOptions::CompiledOptions(const Options& options)
+    : options_(options) {
+    options_.strip_tags = lowercase_all(options.strip_tags);
+    options_.convert_tags = lowercase_all(options.convert_tags);
+    options_.keep_inline_images_in = lowercase_all(options.keep_inline_images_in);
+    options_.tag_actions.clear();
+    for (const auto& [name, action] : options.tag_actions) {
+        if (!name.empty()) {
+            options_.tag_actions[lowercase(name)] = action;
+        }
+    }
+    if (options_.bullets.empty()) {
+        options_.bullets = Options().bullets;
+    }
+    options_.max_depth = std::max(options_.max_depth, 0);
+
+    for (std::size_t id = 1; id < kTagCount; ++id) {
+        bool converted = options_.should_convert_tag(std::string(tag_name(TagId(id))));
+        actions_[id] = converted ? TagAction::CONVERT : TagAction::SKIP;
+    }
+    // script and style: dropped with their content.
+    actions_[tag_index(TagId::SCRIPT)] = TagAction::SKIP;
+    actions_[tag_index(TagId::STYLE)] = TagAction::SKIP;
+    for (const auto& [name, action] : options_.tag_actions) {
+        TagId tag = lookup_tag(name);
+        if (tag != TagId::UNKNOWN) {
+            actions_[tag_index(tag)] = action;
+        } else {
+            unknown_actions_.emplace_back(name, action);
+        }
+    }
+    std::sort(unknown_actions_.begin(), unknown_actions_.end());
+    if (!options_.strip_tags.empty()) {
+        unknown_exceptions_ = unknown_names(options_.strip_tags);
+    } else if (!options_.convert_tags.empty()) {
+        converts_unknown_ = false;
+        unknown_exceptions_ = unknown_names(options_.convert_tags);
+    }
+
+    for (const std::string& name : options_.keep_inline_images_in) {
+        TagId tag = lookup_tag(name);
+        if (tag != TagId::UNKNOWN) {
+            keep_images_in_.set(tag_index(tag));
+        }
+    }
+    unknown_keep_images_in_ = unknown_names(options_.keep_inline_images_in);
+
+    detail::Hash128 hash = fingerprint(options_);
+    fingerprint_[0] = hash.low;
+    fingerprint_[1] = hash.high;
+}
+
+TagAction CompiledOptions::action(std::string_view name) const {
+    if (!unknown_actions_.empty()) {
+        auto found = std::lower_bound(
+            unknown_actions_.begin(), unknown_actions_.end(), name,
+            [](const auto& entry, std::string_view key) { return entry.first < key; });
+        if (found != unknown_actions_.end() && found->first == name) {
+            return found->second;
+        }
+    }
+    bool converted = unknown_exceptions_.empty()
+                         ? converts_unknown_
+                         : contains(unknown_exceptions_, name) != converts_unknown_;
+    return converted ? TagAction::CONVERT : TagAction::SKIP;
+}
+
+bool CompiledOptions::keeps_inline_images(const HtmlNode* element) const {
+    if (!element->is_element()) {
+        return false;
+    }
+    if (element->tag != TagId::UNKNOWN) {
+        return keep_images_in_[tag_index(element->tag)];
+    }
+    return !unknown_keep_images_in_.empty() && contains(unknown_keep_images_in_, element->name);
+}
+
+}
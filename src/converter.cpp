@@ -1,559 +1,1239 @@
 #include "markdownify/converter.hpp"
-#include <sstream>
+#include "hash.hpp"
+#include "mapped_file.hpp"
+#include "subtree_memo.hpp"
+#include "table_builder.hpp"
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cctype>
-#include <regex>
+#include <chrono>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
 
 namespace markdownify {
 
-static std::string preprocess_html(const std::string& html) {
-    static const std::regex self_closing_pattern(
-        R"(<(area|base|br|col|embed|hr|img|input|link|meta|param|source|track|wbr)([^>]*)>)",
-        std::regex_constants::icase
-    );
+namespace {
 
-    std::string result = std::regex_replace(html, self_closing_pattern, "<$1$2/>");
-    return result;
-}
+using Clock = std::chrono::steady_clock;
 
-MarkdownConverter::MarkdownConverter(const Options& options)
-    : options_(options) {}
+// Output converted for a sink is passed on once it holds this much.
+constexpr std::size_t kSinkChunkSize = 16 * 1024;
 
-std::string MarkdownConverter::convert(const std::string& html) {
-    tinyxml2::XMLDocument doc;
+// Counts the nodes below root and their depth, walking the parent links
+// rather than recursing.
+void count_nodes(const HtmlNode* root, ConversionStats& stats) {
+    std::size_t depth = 0;
+    const HtmlNode* node = root->first_child;
+    if (node) {
+        depth = 1;
+    }
+    while (node) {
+        if (node->is_element()) {
+            ++stats.element_count;
+        } else if (node->is_text()) {
+            ++stats.text_node_count;
+        }
+        stats.max_depth = std::max(stats.max_depth, depth);
 
-    std::string preprocessed = preprocess_html(html);
-    std::string wrapped_html = "<html>" + preprocessed + "</html>";
-    doc.Parse(wrapped_html.c_str());
+        if (node->first_child) {
+            node = node->first_child;
+            ++depth;
+            continue;
+        }
+        while (node != root && !node->next_sibling) {
+            node = node->parent;
+            --depth;
+        }
+        node = node == root ? nullptr : node->next_sibling;
+    }
+}
 
-    if (doc.Error()) {
-        return "";
+// Returns false on the first error; a short write is retried with the rest.
+bool write_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+#ifdef _WIN32
+        unsigned count = static_cast<unsigned>(std::min<std::size_t>(data.size(), 1u << 30));
+        int n = ::_write(fd, data.data(), count);
+        if (n < 0) {
+            return false;
+        }
+#else
+        ssize_t n = ::write(fd, data.data(), data.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return false;
+        }
+#endif
+        data.remove_prefix(static_cast<std::size_t>(n));
     }
+    return true;
+}
+
+}
+
+MarkdownConverter::MarkdownConverter(const Options& options)
+    : MarkdownConverter(std::make_shared<const CompiledOptions>(options)) {}
+
+MarkdownConverter::MarkdownConverter(std::shared_ptr<const CompiledOptions> options)
+    : compiled_(std::move(options)) {
+    build_handlers();
+}
+
+std::string MarkdownConverter::convert(std::string_view html) const {
+    HtmlDocument doc;
+    HtmlParser parser(doc);
+    parser.parse_in_place(html);
 
     return convert_soup(doc);
 }
 
-std::string MarkdownConverter::convert_soup(tinyxml2::XMLDocument& doc) {
-    auto root = doc.RootElement();
-    if (!root) {
-        return "";
-    }
+std::string MarkdownConverter::convert(std::string_view html, ConversionStats& stats) const {
+    HtmlDocument doc;
+    HtmlParser parser(doc);
+    MarkdownWriter out;
+    FrameStack frames;
+    convert_measured(html, doc, parser, out, frames, stats);
 
-    std::string result = process_element(root, std::unordered_set<std::string>());
-    return strip_document(result);
+    std::string result;
+    result.swap(out.str());
+    return result;
 }
 
-std::string MarkdownConverter::get_tag_name(tinyxml2::XMLElement* element) {
-    const char* name = element->Name();
-    return name ? std::string(name) : "";
+std::string MarkdownConverter::convert(std::string_view html, SubtreeCache& cache) const {
+    HtmlDocument doc;
+    HtmlParser parser(doc);
+    parser.parse_in_place(html);
+
+    detail::SubtreeMemo& memo = *cache.memo_;
+    memo.begin(this, handlers_version_, doc, options().max_depth > 0);
+    MarkdownWriter out;
+    FrameStack frames;
+    convert_into(doc, out, frames, nullptr, &memo);
+    memo.finish();
+
+    std::string result;
+    result.swap(out.str());
+    return result;
 }
 
-bool MarkdownConverter::should_remove_whitespace_inside(const std::string& tag_name) {
-    if (tag_name.empty()) return false;
+std::string MarkdownConverter::convert(std::string_view html, ResultCache& cache) const {
+    detail::Hasher hasher(compiled_->fingerprint_[0]);
+    hasher.add(compiled_->fingerprint_[1]);
+    hasher.add(handlers_version_);
+    hasher.add(html);
+    detail::Hash128 key = hasher.finish();
 
-    if (tag_name[0] == 'h' && tag_name.length() == 2 &&
-        tag_name[1] >= '1' && tag_name[1] <= '6') {
-        return true;
+    if (std::optional<std::string> markdown = cache.find(key, html)) {
+        return std::move(*markdown);
+    }
+    std::string markdown = convert(html);
+    cache.insert(key, html, markdown);
+    return markdown;
+}
+
+std::optional<std::string> MarkdownConverter::convert_file(const std::string& path) const {
+    detail::MappedFile file;
+    if (!file.open(path)) {
+        return std::nullopt;
     }
+    return convert(file.view());
+}
 
-    static const std::unordered_set<std::string> block_tags = {
-        "p", "blockquote", "article", "div", "section",
-        "ol", "ul", "li", "dl", "dt", "dd",
-        "table", "thead", "tbody", "tfoot", "tr", "td", "th"
-    };
+std::string MarkdownConverter::convert_soup(const HtmlDocument& doc) const {
+    MarkdownWriter out;
+    FrameStack frames;
+    convert_into(doc, out, frames);
+
+    std::string result;
+    result.swap(out.str());
+    return result;
+}
 
-    return block_tags.find(tag_name) != block_tags.end();
+void MarkdownConverter::convert(std::string_view html, const Sink& sink) const {
+    HtmlDocument doc;
+    HtmlParser parser(doc);
+    parser.parse_in_place(html);
+
+    convert_soup(doc, sink);
+}
+
+void MarkdownConverter::convert_soup(const HtmlDocument& doc, const Sink& sink) const {
+    MarkdownWriter out;
+    FrameStack frames;
+    convert_chunked(doc, out, frames, sink);
 }
 
-bool MarkdownConverter::should_remove_whitespace_outside(const std::string& tag_name) {
-    return should_remove_whitespace_inside(tag_name) || tag_name == "pre";
+bool MarkdownConverter::convert(std::string_view html, std::ostream& out) const {
+    convert(html, [&out](std::string_view chunk) {
+        if (out) {
+            out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        }
+    });
+    return static_cast<bool>(out);
 }
 
-std::string MarkdownConverter::process_element(tinyxml2::XMLNode* node,
-                                              const std::unordered_set<std::string>& parent_tags) {
-    if (!node) return "";
+bool MarkdownConverter::convert_to_fd(std::string_view html, int fd) const {
+    bool ok = true;
+    convert(html, [fd, &ok](std::string_view chunk) {
+        ok = ok && write_all(fd, chunk);
+    });
+    return ok;
+}
+
+void MarkdownConverter::convert_into(const HtmlDocument& doc, MarkdownWriter& out,
+                                     FrameStack& frames, ConversionStats* stats,
+                                     detail::SubtreeMemo* memo) const {
+    auto root = doc.root();
+    if (!root) {
+        return;
+    }
 
-    if (auto element = node->ToElement()) {
-        return process_tag(element, parent_tags);
-    } else if (auto text = node->ToText()) {
-        return process_text(text, parent_tags);
+    ParentContext context;
+    context.stats = stats;
+    context.memo = memo;
+    if (!stats) {
+        for (auto child = root->first_child; child; child = child->next_sibling) {
+            walk(child, context, frames, out);
+        }
+        strip_document(out.str());
+        return;
     }
 
-    return "";
+    auto start = Clock::now();
+    for (auto child = root->first_child; child; child = child->next_sibling) {
+        walk(child, context, frames, out);
+    }
+    auto walked = Clock::now();
+    strip_document(out.str());
+    stats->walk_time = walked - start;
+    stats->strip_time = Clock::now() - walked;
 }
 
-std::string MarkdownConverter::process_text(tinyxml2::XMLText* text,
-                                           const std::unordered_set<std::string>& parent_tags) {
-    if (!text) return "";
+// Transparent containers are descended into rather than walked whole, as
+// their Markdown is that of their children. Past max_depth they are walked
+// whole, so that they are flattened as in convert_into.
+void MarkdownConverter::convert_chunked(const HtmlDocument& doc, MarkdownWriter& out,
+                                        FrameStack& frames, const Sink& sink) const {
+    auto root = doc.root();
+    if (!root) {
+        return;
+    }
 
-    const char* value = text->Value();
-    if (!value) return "";
+    StripBoundary strip(options().strip_document);
+    std::size_t max_depth = static_cast<std::size_t>(options().max_depth);
+    std::size_t depth = 1;
+    const HtmlNode* node = root->first_child;
+    while (node) {
+        if (node->is_element() && node->first_child && is_transparent(node->tag) &&
+            (max_depth == 0 || depth < max_depth)) {
+            node = node->first_child;
+            ++depth;
+            continue;
+        }
 
-    std::string text_content(value);
+        walk(node, ParentContext(), frames, out);
+        if (out.size() >= kSinkChunkSize) {
+            strip.push(out.view(), sink);
+            out.clear();
+        }
 
-    if (parent_tags.find("_noformat") != parent_tags.end()) {
-        return text_content;
+        while (node != root && !node->next_sibling) {
+            node = node->parent;
+            --depth;
+        }
+        node = node == root ? nullptr : node->next_sibling;
     }
+    strip.push(out.view(), sink);
+}
 
-    text_content = collapse_whitespace(text_content);
-    return escape(text_content, parent_tags);
+void MarkdownConverter::convert_measured(std::string_view html, HtmlDocument& doc,
+                                         HtmlParser& parser, MarkdownWriter& out,
+                                         FrameStack& frames, ConversionStats& stats) const {
+    stats = ConversionStats();
+    stats.input_bytes = html.size();
+
+    std::size_t blocks = doc.block_count();
+    auto start = Clock::now();
+    parser.parse_in_place(html);
+    stats.parse_time = Clock::now() - start;
+    stats.arena_blocks = doc.block_count() - blocks;
+
+    count_nodes(doc.root(), stats);
+    convert_into(doc, out, frames, &stats);
+    stats.output_bytes = out.size();
 }
 
-std::string MarkdownConverter::process_tag(tinyxml2::XMLElement* element,
-                                          const std::unordered_set<std::string>& parent_tags) {
-    if (!element) return "";
+bool MarkdownConverter::should_remove_whitespace_inside(TagId tag) const {
+    switch (tag) {
+        case TagId::H1: case TagId::H2: case TagId::H3:
+        case TagId::H4: case TagId::H5: case TagId::H6:
+        case TagId::P: case TagId::BLOCKQUOTE: case TagId::ARTICLE:
+        case TagId::DIV: case TagId::SECTION:
+        case TagId::OL: case TagId::UL: case TagId::LI:
+        case TagId::DL: case TagId::DT: case TagId::DD:
+        case TagId::TABLE: case TagId::THEAD: case TagId::TBODY: case TagId::TFOOT:
+        case TagId::TR: case TagId::TD: case TagId::TH:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool MarkdownConverter::should_remove_whitespace_outside(TagId tag) const {
+    return should_remove_whitespace_inside(tag) || tag == TagId::PRE;
+}
 
-    std::string tag_name = get_tag_name(element);
-    if (tag_name.empty()) return "";
-
-    std::transform(tag_name.begin(), tag_name.end(), tag_name.begin(), ::tolower);
-
-    if (!options_.should_convert_tag(tag_name)) {
-        return "";
-    }
-
-    auto new_parent_tags = parent_tags;
-    new_parent_tags.insert(tag_name);
-
-    if ((tag_name[0] == 'h' && tag_name.length() == 2) ||
-        tag_name == "td" || tag_name == "th") {
-        new_parent_tags.insert("_inline");
+// Containers whose Markdown is exactly the concatenation of their children.
+bool MarkdownConverter::is_transparent(TagId tag) const {
+    switch (tag) {
+        case TagId::HTML: case TagId::BODY: case TagId::DIV:
+        case TagId::SECTION: case TagId::ARTICLE: case TagId::MAIN:
+        case TagId::HEADER: case TagId::FOOTER: case TagId::NAV: case TagId::ASIDE:
+            return compiled_->action(tag) != TagAction::SKIP && custom_index_[tag_index(tag)] == 0;
+        default:
+            return false;
+    }
+}
+
+void MarkdownConverter::build_handlers() {
+    using M = MarkdownConverter;
+    auto set = [this](TagId tag, TagHandler handler) { handlers_[tag_index(tag)] = handler; };
+
+    TagHandler em = {&M::open_inline<'*', 1>, &M::close_inline<'*', 1>};
+    TagHandler strong = {&M::open_inline<'*', 2>, &M::close_inline<'*', 2>};
+    if (options().strong_em_symbol == StrongEmSymbol::UNDERSCORE) {
+        em = {&M::open_inline<'_', 1>, &M::close_inline<'_', 1>};
+        strong = {&M::open_inline<'_', 2>, &M::close_inline<'_', 2>};
+    }
+    TagHandler strike = {&M::open_inline<'~', 2>, &M::close_inline<'~', 2>};
+
+    auto headings = [&](auto style) {
+        constexpr HeadingStyle S = decltype(style)::value;
+        set(TagId::H1, {&M::open_h<S, 1>, &M::close_h<S, 1>});
+        set(TagId::H2, {&M::open_h<S, 2>, &M::close_h<S, 2>});
+        set(TagId::H3, {&M::open_h<S, 3>, &M::close_h<S, 3>});
+        set(TagId::H4, {&M::open_h<S, 4>, &M::close_h<S, 4>});
+        set(TagId::H5, {&M::open_h<S, 5>, &M::close_h<S, 5>});
+        set(TagId::H6, {&M::open_h<S, 6>, &M::close_h<S, 6>});
+    };
+    if (options().heading_style == HeadingStyle::ATX) {
+        headings(std::integral_constant<HeadingStyle, HeadingStyle::ATX>());
+    } else if (options().heading_style == HeadingStyle::ATX_CLOSED) {
+        headings(std::integral_constant<HeadingStyle, HeadingStyle::ATX_CLOSED>());
+    } else {
+        headings(std::integral_constant<HeadingStyle, HeadingStyle::SETEXT>());
     }
 
-    if (tag_name == "pre" || tag_name == "code" ||
-        tag_name == "kbd" || tag_name == "samp") {
-        new_parent_tags.insert("_noformat");
+    OpenStep br = &M::open_br<NewlineStyle::SPACES>;
+    if (options().newline_style == NewlineStyle::BACKSLASH) {
+        br = &M::open_br<NewlineStyle::BACKSLASH>;
     }
 
-    if (tag_name == "ol") {
-        list_depth_++;
-        list_counters_.push_back(1);
-    } else if (tag_name == "ul") {
-        list_depth_++;
+    set(TagId::A, {&M::open_a, &M::close_a});
+    set(TagId::B, strong);
+    set(TagId::BLOCKQUOTE, {&M::open_blockquote, &M::close_blockquote});
+    set(TagId::BR, {br, nullptr});
+    set(TagId::CODE, {&M::open_code, &M::close_code});
+    set(TagId::DEL, strike);
+    set(TagId::EM, em);
+    set(TagId::HR, {&M::open_hr, nullptr});
+    set(TagId::I, em);
+    set(TagId::IMG, {&M::open_img, nullptr});
+    set(TagId::LI, {nullptr, &M::close_li});
+    set(TagId::OL, {&M::open_list, &M::close_list});
+    set(TagId::P, {&M::open_p, &M::close_p});
+    set(TagId::PRE, {&M::open_pre, &M::close_pre});
+    set(TagId::S, strike);
+    set(TagId::STRIKE, strike);
+    set(TagId::STRONG, strong);
+    set(TagId::TABLE, {&M::open_table, &M::close_table});
+    set(TagId::TD, {nullptr, &M::close_cell});
+    set(TagId::TH, {nullptr, &M::close_cell});
+    set(TagId::TR, {&M::open_tr, &M::close_tr});
+    set(TagId::UL, {&M::open_list, &M::close_list});
+
+    // Without a symbol, sub and sup are plain text.
+    if (!options().sub_symbol.empty()) {
+        set(TagId::SUB, {&M::open_sub_sup, &M::close_sub_sup});
     }
+    if (!options().sup_symbol.empty()) {
+        set(TagId::SUP, {&M::open_sub_sup, &M::close_sub_sup});
+    }
+}
 
-    std::ostringstream child_text;
-    for (auto child = element->FirstChild(); child; child = child->NextSibling()) {
-        child_text << process_element(child, new_parent_tags);
+bool MarkdownConverter::set_handler(std::string_view tag, CustomHandler handler) {
+    std::string name(tag);
+    for (char& c : name) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    TagId id = lookup_tag(name);
+    if (name.empty() || !handler || id == TagId::TR || id == TagId::THEAD ||
+        id == TagId::TBODY || id == TagId::TFOOT) {
+        return false;
     }
 
-    std::string text = child_text.str();
+    auto found = std::lower_bound(custom_handlers_.begin(), custom_handlers_.end(), name,
+                                  [](const auto& entry, const std::string& n) {
+                                      return entry.first < n;
+                                  });
+    if (found != custom_handlers_.end() && found->first == name) {
+        found->second = std::move(handler);
+    } else {
+        custom_handlers_.emplace(found, std::move(name), std::move(handler));
+    }
+
+    static std::atomic<std::uint64_t> versions{0};
+    handlers_version_ = ++versions;
 
-    if (tag_name == "ol") {
-        list_counters_.pop_back();
-        list_depth_--;
-    } else if (tag_name == "ul") {
-        list_depth_--;
+    custom_index_.fill(0);
+    for (std::size_t i = 0; i < custom_handlers_.size(); ++i) {
+        std::size_t index = tag_index(lookup_tag(custom_handlers_[i].first));
+        if (index != tag_index(TagId::UNKNOWN)) {
+            custom_index_[index] = static_cast<std::uint16_t>(i + 1);
+        }
+        handlers_[index] = {nullptr, &MarkdownConverter::close_custom};
     }
+    return true;
+}
+
+MarkdownConverter::FrameStack::FrameStack() = default;
 
-    if (tag_name == "a") {
-        return convert_a(element, text, parent_tags);
-    } else if (tag_name == "blockquote") {
-        return convert_blockquote(element, text, parent_tags);
-    } else if (tag_name == "br") {
-        return convert_br(element, text, parent_tags);
-    } else if (tag_name == "code") {
-        return convert_code(element, text, parent_tags);
-    } else if (tag_name == "em") {
-        return convert_em(element, text, parent_tags);
-    } else if (tag_name == "strong") {
-        return convert_strong(element, text, parent_tags);
-    } else if (tag_name == "b") {
-        return convert_b(element, text, parent_tags);
-    } else if (tag_name == "i") {
-        return convert_i(element, text, parent_tags);
-    } else if (tag_name == "del" || tag_name == "s" || tag_name == "strike") {
-        return convert_del(element, text, parent_tags);
-    } else if (tag_name == "hr") {
-        return convert_hr(element, text, parent_tags);
-    } else if (tag_name[0] == 'h' && tag_name.length() == 2 &&
-               tag_name[1] >= '1' && tag_name[1] <= '6') {
-        int level = tag_name[1] - '0';
-        return convert_h(element, text, parent_tags, level);
-    } else if (tag_name == "img") {
-        return convert_img(element, text, parent_tags);
-    } else if (tag_name == "li") {
-        return convert_li(element, text, parent_tags);
-    } else if (tag_name == "ol") {
-        return convert_ol(element, text, parent_tags);
-    } else if (tag_name == "ul") {
-        return convert_ul(element, text, parent_tags);
-    } else if (tag_name == "p") {
-        return convert_p(element, text, parent_tags);
-    } else if (tag_name == "pre") {
-        return convert_pre(element, text, parent_tags);
-    } else if (tag_name == "table") {
-        return convert_table(element, text, parent_tags);
-    } else if (tag_name == "tr") {
-        return convert_tr(element, text, parent_tags);
-    } else if (tag_name == "td") {
-        return convert_td(element, text, parent_tags);
-    } else if (tag_name == "th") {
-        return convert_th(element, text, parent_tags);
-    } else if (tag_name == "script" || tag_name == "style") {
-        return "";
+MarkdownConverter::FrameStack::~FrameStack() = default;
+
+MarkdownConverter::Frame& MarkdownConverter::FrameStack::push_back() {
+    if (size_ == blocks_.size() * kBlockSize) {
+        blocks_.push_back(std::make_unique<Frame[]>(kBlockSize));
     }
+    Frame& frame = at(size_++);
+    frame = Frame();
+    return frame;
+}
 
-    return text;
+detail::TableBuilder& MarkdownConverter::FrameStack::push_table() {
+    if (table_count_ == tables_.size()) {
+        tables_.push_back(std::make_unique<detail::TableBuilder>());
+    }
+    detail::TableBuilder& table = *tables_[table_count_++];
+    table.clear();
+    return table;
 }
 
-std::string MarkdownConverter::escape(const std::string& text,
-                                     const std::unordered_set<std::string>& parent_tags) {
-    if (text.empty()) return "";
+void MarkdownConverter::walk(const HtmlNode* node, const ParentContext& context,
+                             FrameStack& frames, MarkdownWriter& out) const {
+    if (node->is_text()) {
+        process_text(node, context, out);
+        return;
+    }
+    if (!node->is_element()) {
+        return;
+    }
 
-    if (parent_tags.find("_noformat") != parent_tags.end()) {
-        return text;
+    std::size_t depth = 0;
+    for (const HtmlNode* ancestor = node; ancestor->parent; ancestor = ancestor->parent) {
+        ++depth;
     }
 
-    return escape_markdown(text, options_.escape_asterisks,
-                          options_.escape_underscores, options_.escape_misc);
+    std::size_t base = frames.size();
+    enter(node, context, depth, frames, out);
+    while (frames.size() > base) {
+        Frame& frame = frames.back();
+        if (const HtmlNode* child = frame.next_child) {
+            frame.next_child = child->next_sibling;
+            if (child->is_element()) {
+                enter(child, frame.children, frame.depth + 1, frames, out);
+            } else if (child->is_text()) {
+                process_text(child, frame.children, out);
+            }
+            continue;
+        }
+
+        if (frame.close) {
+            (this->*frame.close)(frame, *frame.context, out);
+        }
+        if (frame.memoize) {
+            frame.context->memo->store(out.view(frame.start));
+        }
+        if (frame.element->tag == TagId::TABLE && frame.children.table) {
+            frames.pop_table();
+        }
+        frames.pop_back();
+    }
 }
 
-std::string MarkdownConverter::inline_markup(const std::string& markup_prefix,
-                                            const std::string& text,
-                                            const std::unordered_set<std::string>& parent_tags) {
-    std::string markup_suffix = markup_prefix;
+void MarkdownConverter::enter(const HtmlNode* element, const ParentContext& context,
+                              std::size_t depth, FrameStack& frames,
+                              MarkdownWriter& out) const {
+    if (element->name.empty()) {
+        return;
+    }
+    TagAction action = compiled_->action(element);
+    if (action == TagAction::SKIP) {
+        return;
+    }
+
+    if (options().max_depth > 0 && depth > static_cast<std::size_t>(options().max_depth)) {
+        flatten(element, context, out);
+        return;
+    }
+
+    bool memoize = false;
+    if (context.memo) {
+        auto lookup = context.memo->lookup(element, context, depth, out);
+        if (lookup == detail::SubtreeMemo::Lookup::HIT) {
+            return;
+        }
+        memoize = lookup == detail::SubtreeMemo::Lookup::MISS;
+    }
 
-    if (!markup_prefix.empty() && markup_prefix[0] == '<' &&
-        markup_prefix.back() == '>') {
-        markup_suffix = "</" + markup_prefix.substr(1);
+    TagHandler handler = action == TagAction::CONVERT ? handlers_[tag_index(element->tag)]
+                                                      : TagHandler{};
+    Frame& frame = frames.push_back();
+    frame.element = element;
+    frame.next_child = element->first_child;
+    frame.context = &context;
+    frame.close = handler.close;
+    frame.start = out.size();
+    frame.body = frame.start;
+    frame.depth = depth;
+    frame.memoize = memoize;
+    if (handler.open && !(this->*handler.open)(frame, context, out)) {
+        if (memoize) {
+            context.memo->store(out.view(frame.start));
+        }
+        frames.pop_back();
+        return;
     }
 
-    if (parent_tags.find("_noformat") != parent_tags.end()) {
-        return text;
+    ParentContext& child_context = frame.children;
+    child_context = context;
+    if (action == TagAction::UNWRAP) {
+        // Rows of an unwrapped table are written inline.
+        if (element->tag == TagId::TABLE) {
+            child_context.table = nullptr;
+        }
+        return;
+    }
+    if (element->tag != TagId::UNKNOWN) {
+        child_context.tags.set(tag_index(element->tag));
     }
 
-    auto chomped = chomp(text);
-    if (chomped.text.empty()) {
-        return "";
+    std::string_view name = element->name;
+    if ((name.size() == 2 && name[0] == 'h') ||
+        element->tag == TagId::TD || element->tag == TagId::TH) {
+        child_context.inline_only = true;
     }
 
-    return chomped.prefix + markup_prefix + chomped.text +
-           markup_suffix + chomped.suffix;
+    if (element->tag == TagId::PRE || element->tag == TagId::CODE ||
+        element->tag == TagId::KBD || element->tag == TagId::SAMP) {
+        child_context.no_format = true;
+    }
+
+    if (element->tag == TagId::OL) {
+        child_context.list_depth++;
+        child_context.list_counter = &frame.list_counter;
+    } else if (element->tag == TagId::UL) {
+        child_context.list_depth++;
+    } else if (element->tag == TagId::TABLE) {
+        // Rows of a table with a custom handler are written inline.
+        child_context.table = custom_index_[tag_index(TagId::TABLE)] == 0 ? &frames.push_table()
+                                                                          : nullptr;
+    }
 }
 
-std::string MarkdownConverter::convert_a(tinyxml2::XMLElement* el, const std::string& text,
-                                        const std::unordered_set<std::string>& parent_tags) {
-    if (parent_tags.find("_noformat") != parent_tags.end()) {
-        return text;
+// Text nodes are written with the context of the cut-off element; elements
+// that would be dropped keep their text out.
+void MarkdownConverter::flatten(const HtmlNode* element, const ParentContext& context,
+                                MarkdownWriter& out) const {
+    const HtmlNode* node = element;
+    while (node) {
+        if (node->is_text()) {
+            process_text(node, context, out);
+        } else if (node->first_child && compiled_->action(node) != TagAction::SKIP) {
+            node = node->first_child;
+            continue;
+        }
+        while (node != element && !node->next_sibling) {
+            node = node->parent;
+        }
+        node = node == element ? nullptr : node->next_sibling;
     }
+}
 
-    auto chomped = chomp(text);
-    if (chomped.text.empty()) {
-        return "";
+void MarkdownConverter::process_text(const HtmlNode* text, const ParentContext& context,
+                                     MarkdownWriter& out) const {
+    std::string_view value = text->value;
+
+    if (context.no_format) {
+        out.append(value);
+        return;
     }
 
-    const char* href = el->Attribute("href");
-    const char* title = el->Attribute("title");
+    // Whitespace-only text next to a block boundary is markup indentation,
+    // not content.
+    if (value.find_first_not_of(" \t\n") == std::string_view::npos) {
+        const HtmlNode* prev = text->prev_sibling;
+        const HtmlNode* next = text->next_sibling;
+        const HtmlNode* parent = text->parent;
+        bool block_parent = !parent->is_element() ||
+                            should_remove_whitespace_inside(parent->tag);
+        if ((prev && should_remove_whitespace_outside(prev->tag)) ||
+            (next && should_remove_whitespace_outside(next->tag)) ||
+            (block_parent && (!prev || !next))) {
+            return;
+        }
+    }
+
+    std::string& collapsed = out.scratch();
+    collapsed.clear();
+    collapse_whitespace(value, collapsed);
+    escape(collapsed, context, out);
+}
 
-    std::string href_str = href ? href : "";
-    std::string title_str = title ? title : "";
+void MarkdownConverter::escape(std::string_view text, const ParentContext& context,
+                               MarkdownWriter& out) const {
+    if (text.empty()) return;
 
-    std::string unescaped_text = chomped.text;
-    size_t pos = 0;
-    while ((pos = unescaped_text.find("\\_", pos)) != std::string::npos) {
-        unescaped_text.replace(pos, 2, "_");
-        pos += 1;
+    if (context.no_format) {
+        out.append(text);
+        return;
     }
 
-    if (options_.autolinks && unescaped_text == href_str && title_str.empty()) {
-        return chomped.prefix + "<" + href_str + ">" + chomped.suffix;
+    if (!context.stats) {
+        escape_markdown(text, options().escape_asterisks, options().escape_underscores,
+                        options().escape_misc, out.str());
+        return;
     }
 
-    if (!title_str.empty()) {
-        return chomped.prefix + "[" + chomped.text + "](" +
-               href_str + " \"" + title_str + "\")" + chomped.suffix;
+    auto start = Clock::now();
+    escape_markdown(text, options().escape_asterisks, options().escape_underscores,
+                    options().escape_misc, out.str());
+    context.stats->escape_time += Clock::now() - start;
+}
+
+namespace {
+
+// Leading and trailing spaces of a text, the parts chomp() splits off.
+struct SpaceRuns {
+    std::size_t leading;
+    std::size_t trailing;
+    bool blank;
+};
+
+SpaceRuns space_runs(std::string_view text) {
+    std::size_t begin = text.find_first_not_of(' ');
+    if (begin == std::string_view::npos) {
+        return {text.size(), 0, true};
     }
+    return {begin, text.size() - 1 - text.find_last_not_of(' '), false};
+}
+
+// True when text reads as href once its escaped underscores are unescaped.
+bool equals_unescaped(std::string_view text, std::string_view href) {
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < text.size(); ++i, ++j) {
+        if (text[i] == '\\' && i + 1 < text.size() && text[i + 1] == '_') {
+            ++i;
+        }
+        if (j >= href.size() || text[i] != href[j]) {
+            return false;
+        }
+    }
+    return j == href.size();
+}
 
-    return chomped.prefix + "[" + chomped.text + "](" +
-           href_str + ")" + chomped.suffix;
 }
 
-std::string MarkdownConverter::convert_blockquote(tinyxml2::XMLElement* el,
-                                                  const std::string& text,
-                                                  const std::unordered_set<std::string>& parent_tags) {
-    std::istringstream stream(text);
-    std::ostringstream result;
-    std::string line;
+namespace {
+
+// Count copies of Symbol, and the same after a space.
+template <char Symbol, std::size_t Count>
+struct InlineMarkup {
+    static constexpr char spaced[] = {' ', Symbol, Symbol};
+    static constexpr std::string_view markup{spaced + 1, Count};
+    static constexpr std::string_view spaced_markup{spaced, Count + 1};
+};
+
+}
 
-    while (std::getline(stream, line)) {
-        result << "> " << line << "\n";
+// b, strong, em, i, del, s and strike. The markup is written ahead of the
+// children as a placeholder and patched in place once the leading spaces
+// are known.
+template <char Symbol, std::size_t Count>
+bool MarkdownConverter::open_inline(Frame& frame, const ParentContext& context,
+                                    MarkdownWriter& out) const {
+    if (context.no_format) {
+        frame.close = nullptr;
+        return true;
     }
 
-    return "\n" + result.str() + "\n";
+    out.append(InlineMarkup<Symbol, Count>::markup);
+    frame.body = out.size();
+    return true;
 }
 
-std::string MarkdownConverter::convert_br(tinyxml2::XMLElement* el, const std::string& text,
-                                         const std::unordered_set<std::string>& parent_tags) {
-    if (options_.newline_style == NewlineStyle::SPACES) {
-        return "  \n";
-    } else {
-        return "\\\n";
+template <char Symbol, std::size_t Count>
+void MarkdownConverter::close_inline(Frame& frame, const ParentContext& /*context*/,
+                                     MarkdownWriter& out) const {
+    using Markup = InlineMarkup<Symbol, Count>;
+
+    SpaceRuns spaces = space_runs(out.view(frame.body));
+    if (spaces.blank) {
+        out.truncate(frame.start);
+        return;
+    }
+
+    out.truncate(out.size() - spaces.trailing);
+    out.append(Markup::markup);
+    if (spaces.trailing > 0) {
+        out.append(' ');
+    }
+
+    out.replace(frame.start, Count + spaces.leading,
+                spaces.leading > 0 ? Markup::spaced_markup : Markup::markup);
+}
+
+// sub_symbol or sup_symbol around the text. A symbol that looks like an
+// HTML tag is closed with the matching end tag.
+bool MarkdownConverter::open_sub_sup(Frame& frame, const ParentContext& context,
+                                     MarkdownWriter& /*out*/) const {
+    if (context.no_format) {
+        frame.close = nullptr;
     }
+    return true;
 }
 
-std::string MarkdownConverter::convert_code(tinyxml2::XMLElement* el, const std::string& text,
-                                           const std::unordered_set<std::string>& parent_tags) {
-    if (parent_tags.find("pre") != parent_tags.end()) {
-        return text;
+void MarkdownConverter::close_sub_sup(Frame& frame, const ParentContext& /*context*/,
+                                      MarkdownWriter& out) const {
+    SpaceRuns spaces = space_runs(out.view(frame.body));
+    if (spaces.blank) {
+        out.truncate(frame.start);
+        return;
     }
 
-    if (text.empty()) {
-        return "";
+    std::string_view symbol = frame.element->tag == TagId::SUB ? options().sub_symbol
+                                                               : options().sup_symbol;
+    out.truncate(out.size() - spaces.trailing);
+    if (symbol.size() > 1 && symbol.front() == '<' && symbol.back() == '>') {
+        out.append("</");
+        out.append(symbol.substr(1));
+    } else {
+        out.append(symbol);
+    }
+    if (spaces.trailing > 0) {
+        out.append(' ');
     }
 
-    int backtick_count = 1;
-    std::smatch match;
-    std::string temp = text;
-    while (std::regex_search(temp, match, RegexPatterns::backtick_runs())) {
-        backtick_count = std::max(backtick_count, static_cast<int>(match.str().length()) + 1);
-        temp = match.suffix();
+    out.replace(frame.body, spaces.leading, symbol);
+    if (spaces.leading > 0) {
+        out.insert(frame.body, " ");
     }
+}
 
-    std::string backticks(backtick_count, '`');
-    std::string space = (text[0] == '`' || text.back() == '`') ? " " : "";
+bool MarkdownConverter::open_a(Frame& frame, const ParentContext& context,
+                               MarkdownWriter& out) const {
+    if (context.no_format) {
+        frame.close = nullptr;
+        return true;
+    }
 
-    return backticks + space + text + space + backticks;
+    out.append('[');
+    frame.body = out.size();
+    return true;
 }
 
-std::string MarkdownConverter::convert_em(tinyxml2::XMLElement* el, const std::string& text,
-                                         const std::unordered_set<std::string>& parent_tags) {
-    char symbol = (options_.strong_em_symbol == StrongEmSymbol::ASTERISK) ? '*' : '_';
-    return inline_markup(std::string(1, symbol), text, parent_tags);
+void MarkdownConverter::close_a(Frame& frame, const ParentContext& /*context*/,
+                                MarkdownWriter& out) const {
+    std::size_t start = frame.start;
+    std::size_t body = frame.body;
+    SpaceRuns spaces = space_runs(out.view(body));
+    if (spaces.blank) {
+        out.truncate(start);
+        return;
+    }
+
+    std::string_view href = frame.element->attribute("href");
+    std::string_view title = frame.element->attribute("title");
+    if (title.empty() && options().default_title) {
+        title = href;
+    }
+    std::string_view suffix = spaces.trailing > 0 ? " " : "";
+
+    out.truncate(out.size() - spaces.trailing);
+    std::string_view link_text = out.view(body + spaces.leading);
+
+    if (options().autolinks && title.empty()) {
+        if (equals_unescaped(link_text, href)) {
+            out.truncate(start);
+            if (spaces.leading > 0) {
+                out.append(' ');
+            }
+            out.append('<');
+            out.append(href);
+            out.append('>');
+            out.append(suffix);
+            return;
+        }
+    }
+
+    out.append("](");
+    out.append(href);
+    if (!title.empty()) {
+        out.append(" \"");
+        out.append(title);
+        out.append('"');
+    }
+    out.append(')');
+    out.append(suffix);
+    out.replace(start, 1 + spaces.leading, spaces.leading > 0 ? " [" : "[");
 }
 
-std::string MarkdownConverter::convert_strong(tinyxml2::XMLElement* el, const std::string& text,
-                                             const std::unordered_set<std::string>& parent_tags) {
-    char symbol = (options_.strong_em_symbol == StrongEmSymbol::ASTERISK) ? '*' : '_';
-    return inline_markup(std::string(2, symbol), text, parent_tags);
+bool MarkdownConverter::open_blockquote(Frame& frame, const ParentContext& /*context*/,
+                                        MarkdownWriter& out) const {
+    out.append('\n');
+    frame.body = out.size();
+    return true;
 }
 
-std::string MarkdownConverter::convert_b(tinyxml2::XMLElement* el, const std::string& text,
-                                        const std::unordered_set<std::string>& parent_tags) {
-    return convert_strong(el, text, parent_tags);
+void MarkdownConverter::close_blockquote(Frame& frame, const ParentContext& /*context*/,
+                                         MarkdownWriter& out) const {
+    out.prefix_lines(frame.body, "> ", "> ");
+    out.append('\n');
 }
 
-std::string MarkdownConverter::convert_i(tinyxml2::XMLElement* el, const std::string& text,
-                                        const std::unordered_set<std::string>& parent_tags) {
-    return convert_em(el, text, parent_tags);
+template <NewlineStyle Style>
+bool MarkdownConverter::open_br(Frame& /*frame*/, const ParentContext& /*context*/,
+                                MarkdownWriter& out) const {
+    out.append(Style == NewlineStyle::SPACES ? "  \n" : "\\\n");
+    return false;
 }
 
-std::string MarkdownConverter::convert_del(tinyxml2::XMLElement* el, const std::string& text,
-                                          const std::unordered_set<std::string>& parent_tags) {
-    return inline_markup("~~", text, parent_tags);
+// The opening backticks depend on the longest backtick run inside, so a
+// single backtick is reserved and widened only when needed.
+bool MarkdownConverter::open_code(Frame& frame, const ParentContext& context,
+                                  MarkdownWriter& out) const {
+    if (context.has(TagId::PRE)) {
+        frame.close = nullptr;
+        return true;
+    }
+
+    out.append('`');
+    frame.body = out.size();
+    return true;
 }
 
-std::string MarkdownConverter::convert_h(tinyxml2::XMLElement* el, const std::string& text,
-                                        const std::unordered_set<std::string>& parent_tags,
-                                        int level) {
-    if (options_.heading_style == HeadingStyle::ATX) {
-        return "\n\n" + std::string(level, '#') + " " + text + "\n\n";
-    } else if (options_.heading_style == HeadingStyle::ATX_CLOSED) {
-        return "\n\n" + std::string(level, '#') + " " + text + " " +
-               std::string(level, '#') + "\n\n";
-    } else {
-        if (level == 1) {
-            return underline(text, '=');
-        } else if (level == 2) {
-            return underline(text, '-');
-        } else {
-            return "\n\n" + std::string(level, '#') + " " + text + "\n\n";
+void MarkdownConverter::close_code(Frame& frame, const ParentContext& /*context*/,
+                                   MarkdownWriter& out) const {
+    std::string_view text = out.view(frame.body);
+    if (text.empty()) {
+        out.truncate(frame.start);
+        return;
+    }
+
+    std::size_t backtick_count = 1;
+    for (std::size_t i = 0; i < text.size();) {
+        if (text[i] != '`') {
+            ++i;
+            continue;
         }
+        std::size_t run = text.find_first_not_of('`', i);
+        run = (run == std::string_view::npos ? text.size() : run) - i;
+        backtick_count = std::max(backtick_count, run + 1);
+        i += run;
     }
+
+    std::string fence(backtick_count, '`');
+    bool padded = text[0] == '`' || text.back() == '`';
+    if (padded) {
+        out.append(' ');
+    }
+    out.append(fence);
+    out.replace(frame.start, 1, padded ? fence + " " : fence);
 }
 
-std::string MarkdownConverter::convert_hr(tinyxml2::XMLElement* el, const std::string& text,
-                                         const std::unordered_set<std::string>& parent_tags) {
-    return "\n\n---\n\n";
+namespace {
+
+constexpr std::string_view kHashes = "###### ";
+
 }
 
-std::string MarkdownConverter::convert_img(tinyxml2::XMLElement* el, const std::string& text,
-                                          const std::unordered_set<std::string>& parent_tags) {
-    const char* alt = el->Attribute("alt");
-    const char* src = el->Attribute("src");
-    const char* title = el->Attribute("title");
+template <HeadingStyle Style, int Level>
+bool MarkdownConverter::open_h(Frame& frame, const ParentContext& /*context*/,
+                               MarkdownWriter& out) const {
+    out.append("\n\n");
+    if (Style == HeadingStyle::SETEXT && Level <= 2) {
+        frame.body = out.size();
+        return true;
+    }
 
-    std::string alt_str = alt ? alt : "";
-    std::string src_str = src ? src : "";
-    std::string title_str = title ? title : "";
+    out.append(kHashes.substr(6 - Level));
+    return true;
+}
 
-    if (parent_tags.find("_inline") != parent_tags.end()) {
-        return alt_str;
+template <HeadingStyle Style, int Level>
+void MarkdownConverter::close_h(Frame& frame, const ParentContext& /*context*/,
+                                MarkdownWriter& out) const {
+    if (Style != HeadingStyle::SETEXT || Level > 2) {
+        if (Style == HeadingStyle::ATX_CLOSED) {
+            out.append(' ');
+            out.append(kHashes.substr(0, Level));
+        }
+        out.append("\n\n");
+        return;
     }
 
-    if (!title_str.empty()) {
-        return "![" + alt_str + "](" + src_str + " \"" + title_str + "\")";
+    std::string_view text = out.view(frame.body);
+    std::size_t length = text.size();
+    while (length > 0 && std::isspace(static_cast<unsigned char>(text[length - 1]))) {
+        --length;
+    }
+    if (length == 0) {
+        out.truncate(frame.start);
+        return;
     }
 
-    return "![" + alt_str + "](" + src_str + ")";
+    out.truncate(frame.body + length);
+    out.append('\n');
+    out.append(length, Level == 1 ? '=' : '-');
+    out.append("\n\n");
 }
 
-std::string MarkdownConverter::convert_li(tinyxml2::XMLElement* el, const std::string& text,
-                                         const std::unordered_set<std::string>& parent_tags) {
-    std::string prefix;
+bool MarkdownConverter::open_hr(Frame& /*frame*/, const ParentContext& /*context*/,
+                                MarkdownWriter& out) const {
+    out.append("\n\n---\n\n");
+    return false;
+}
 
-    if (parent_tags.find("ol") != parent_tags.end()) {
-        int counter = list_counters_.empty() ? 1 : list_counters_.back();
-        prefix = std::to_string(counter) + ". ";
-        if (!list_counters_.empty()) {
-            list_counters_.back()++;
-        }
-    } else {
-        size_t bullet_index = (list_depth_ > 0 ? list_depth_ - 1 : 0) % options_.bullets.size();
-        prefix = options_.bullets[bullet_index] + " ";
+bool MarkdownConverter::open_img(Frame& frame, const ParentContext& context,
+                                 MarkdownWriter& out) const {
+    std::string_view alt = frame.element->attribute("alt");
+    std::string_view src = frame.element->attribute("src");
+    std::string_view title = frame.element->attribute("title");
+
+    if (context.inline_only && !compiled_->keeps_inline_images(frame.element->parent)) {
+        out.append(alt);
+        return false;
     }
 
-    std::istringstream stream(text);
-    std::ostringstream result;
-    std::string line;
-    bool first = true;
+    out.append("![");
+    out.append(alt);
+    out.append("](");
+    out.append(src);
+    if (!title.empty()) {
+        out.append(" \"");
+        out.append(title);
+        out.append('"');
+    }
+    out.append(')');
+    return false;
+}
 
-    while (std::getline(stream, line)) {
-        if (first) {
-            result << prefix << line << "\n";
-            first = false;
-        } else {
-            result << "  " << line << "\n";
-        }
+// The item number is taken after the children are written, as nested items
+// outside their own list still count towards it.
+void MarkdownConverter::close_li(Frame& frame, const ParentContext& context,
+                                 MarkdownWriter& out) const {
+    std::string prefix;
+    if (context.has(TagId::OL)) {
+        int number = context.list_counter ? (*context.list_counter)++ : 1;
+        prefix = std::to_string(number) + ". ";
+    } else {
+        int depth = context.list_depth;
+        size_t bullet_index = (depth > 0 ? depth - 1 : 0) % options().bullets.size();
+        prefix = options().bullets[bullet_index] + " ";
     }
 
-    return result.str();
+    out.prefix_lines(frame.start, prefix, "  ");
 }
 
-std::string MarkdownConverter::convert_ol(tinyxml2::XMLElement* el, const std::string& text,
-                                         const std::unordered_set<std::string>& parent_tags) {
-    return "\n" + text + "\n";
+// ol and ul.
+bool MarkdownConverter::open_list(Frame& /*frame*/, const ParentContext& /*context*/,
+                                  MarkdownWriter& out) const {
+    out.append('\n');
+    return true;
 }
 
-std::string MarkdownConverter::convert_ul(tinyxml2::XMLElement* el, const std::string& text,
-                                         const std::unordered_set<std::string>& parent_tags) {
-    return "\n" + text + "\n";
+void MarkdownConverter::close_list(Frame& /*frame*/, const ParentContext& /*context*/,
+                                   MarkdownWriter& out) const {
+    out.append('\n');
 }
 
-std::string MarkdownConverter::convert_p(tinyxml2::XMLElement* el, const std::string& text,
-                                        const std::unordered_set<std::string>& parent_tags) {
-    if (text.empty()) {
-        return "";
+bool MarkdownConverter::open_p(Frame& frame, const ParentContext& /*context*/,
+                               MarkdownWriter& out) const {
+    out.append("\n\n");
+    frame.body = out.size();
+    return true;
+}
+
+void MarkdownConverter::close_p(Frame& frame, const ParentContext& /*context*/,
+                                MarkdownWriter& out) const {
+    if (out.size() == frame.body) {
+        out.truncate(frame.start);
+        return;
     }
 
-    if (options_.wrap) {
-        return "\n\n" + wrap_text(text, options_.wrap_width) + "\n\n";
+    if (options().wrap) {
+        wrap_text_in_place(out.str(), frame.body, options().wrap_width);
     }
 
-    return "\n\n" + text + "\n\n";
+    out.append("\n\n");
 }
 
-std::string MarkdownConverter::convert_pre(tinyxml2::XMLElement* el, const std::string& text,
-                                          const std::unordered_set<std::string>& parent_tags) {
-    std::string processed_text = text;
-
-    if (options_.strip_pre == StripMode::STRIP) {
-        processed_text = strip_pre(processed_text);
-    } else if (options_.strip_pre == StripMode::STRIP_ONE) {
-        processed_text = strip1_pre(processed_text);
-    }
-
-    std::string lang = options_.code_language;
-    if (options_.code_language_callback) {
-        const char* class_attr = el->Attribute("class");
+bool MarkdownConverter::open_pre(Frame& frame, const ParentContext& /*context*/,
+                                 MarkdownWriter& out) const {
+    std::string lang = options().code_language;
+    if (options().code_language_callback) {
+        const HtmlAttribute* class_attr = frame.element->find_attribute("class");
         if (class_attr) {
-            lang = options_.code_language_callback(class_attr);
+            lang = options().code_language_callback(std::string(class_attr->value));
         }
     }
 
-    return "\n\n```" + lang + "\n" + processed_text + "\n```\n\n";
+    out.append("\n\n```");
+    out.append(lang);
+    out.append('\n');
+    frame.body = out.size();
+    return true;
 }
 
-std::string MarkdownConverter::element_to_html(tinyxml2::XMLElement* element) {
+void MarkdownConverter::close_pre(Frame& frame, const ParentContext& /*context*/,
+                                  MarkdownWriter& out) const {
+    std::size_t body = frame.body;
+    if (options().strip_pre == StripMode::STRIP || options().strip_pre == StripMode::STRIP_ONE) {
+        std::string_view text = out.view(body);
+        std::string_view kept = options().strip_pre == StripMode::STRIP ? strip_pre_view(text)
+                                                                        : strip1_pre_view(text);
+        std::size_t begin = kept.data() - text.data();
+        out.truncate(body + begin + kept.size());
+        out.erase(body, begin);
+    }
+
+    out.append("\n```\n\n");
+}
+
+std::string MarkdownConverter::element_to_html(const HtmlNode* element) const {
     if (!element) return "";
 
-    tinyxml2::XMLPrinter printer;
-    element->Accept(&printer);
-    return std::string(printer.CStr());
+    return to_html(element);
+}
+
+bool MarkdownConverter::open_table(Frame& frame, const ParentContext& /*context*/,
+                                   MarkdownWriter& out) const {
+    out.append("\n\n");
+    if (options().preserve_html_tables) {
+        out.append(element_to_html(frame.element));
+        out.append("\n\n");
+        return false;
+    }
+
+    frame.body = out.size();
+    return true;
 }
 
-std::string MarkdownConverter::convert_table(tinyxml2::XMLElement* el, const std::string& text,
-                                            const std::unordered_set<std::string>& parent_tags) {
-    if (options_.preserve_html_tables) {
-        return "\n\n" + element_to_html(el) + "\n\n";
+// The cells were taken out of the output as they closed; what is left is
+// content outside of them, such as a caption, which goes first.
+void MarkdownConverter::close_table(Frame& frame, const ParentContext& context,
+                                    MarkdownWriter& out) const {
+    detail::TableBuilder& table = *frame.children.table;
+    table.end_row();
+    if (table.empty()) {
+        out.append('\n');
+        return;
     }
 
-    // Count columns in the first row for GFM table separator
-    int column_count = 0;
-    tinyxml2::XMLElement* first_row = nullptr;
+    // A cell holds one line, so a table inside one keeps only its text.
+    if (context.has(TagId::TD) || context.has(TagId::TH)) {
+        table.render_text(out.str());
+        out.append('\n');
+        return;
+    }
 
-    // Try to find first row in thead, then tbody, then directly in table
-    auto thead = el->FirstChildElement("thead");
-    if (thead) {
-        first_row = thead->FirstChildElement("tr");
+    if (out.view(frame.body).find_first_not_of(" \t\n") != std::string_view::npos) {
+        out.append("\n\n");
     }
-    if (!first_row) {
-        auto tbody = el->FirstChildElement("tbody");
-        if (tbody) {
-            first_row = tbody->FirstChildElement("tr");
-        }
+    table.render(out.str(), options().table_infer_header, options().table_align_columns);
+    out.append('\n');
+}
+
+// Rows and cells outside of a table are written inline.
+bool MarkdownConverter::open_tr(Frame& /*frame*/, const ParentContext& context,
+                                MarkdownWriter& out) const {
+    if (context.table) {
+        context.table->start_row(context.has(TagId::THEAD));
+    } else {
+        out.append("| ");
     }
-    if (!first_row) {
-        first_row = el->FirstChildElement("tr");
+    return true;
+}
+
+void MarkdownConverter::close_tr(Frame& /*frame*/, const ParentContext& context,
+                                 MarkdownWriter& out) const {
+    if (context.table) {
+        context.table->end_row();
+    } else {
+        out.append('\n');
     }
+}
 
-    // Count columns (th or td elements in first row)
-    if (first_row) {
-        for (auto cell = first_row->FirstChildElement(); cell; cell = cell->NextSiblingElement()) {
-            std::string tag_name = get_tag_name(cell);
-            std::transform(tag_name.begin(), tag_name.end(), tag_name.begin(), ::tolower);
-            if (tag_name == "th" || tag_name == "td") {
-                column_count++;
-            }
+namespace {
+
+// A colspan or rowspan, clamped the way browsers do.
+std::size_t span_attribute(const HtmlNode* cell, std::string_view name, std::size_t max) {
+    std::string_view value = cell->attribute(name);
+    std::size_t span = 0;
+    for (char c : value) {
+        if (c < '0' || c > '9') {
+            break;
         }
+        span = std::min(span * 10 + static_cast<std::size_t>(c - '0'), max);
     }
+    return span == 0 ? 1 : span;
+}
 
-    // Insert separator row after first line for GFM compatibility
-    std::string result = text;
-    if (column_count > 0) {
-        size_t first_newline = result.find('\n');
-        if (first_newline != std::string::npos) {
-            std::string separator = "|";
-            for (int i = 0; i < column_count; i++) {
-                separator += " --- |";
-            }
-            separator += "\n";
-            result.insert(first_newline + 1, separator);
+bool equals_ignore_case(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) == y;
+           });
+}
+
+// From the align attribute, or else a text-align declaration in style.
+detail::ColumnAlign cell_align(const HtmlNode* cell) {
+    std::string_view value = cell->attribute("align");
+    if (value.empty()) {
+        std::string_view style = cell->attribute("style");
+        std::size_t pos = style.find("text-align");
+        if (pos != std::string_view::npos) {
+            pos = style.find(':', pos);
+        }
+        if (pos != std::string_view::npos) {
+            value = style.substr(pos + 1);
+            std::size_t begin = value.find_first_not_of(' ');
+            value = begin == std::string_view::npos ? std::string_view() : value.substr(begin);
+            value = value.substr(0, value.find_first_of("; !"));
         }
     }
 
-    return "\n\n" + result + "\n";
+    if (equals_ignore_case(value, "left")) return detail::ColumnAlign::LEFT;
+    if (equals_ignore_case(value, "center")) return detail::ColumnAlign::CENTER;
+    if (equals_ignore_case(value, "right")) return detail::ColumnAlign::RIGHT;
+    return detail::ColumnAlign::NONE;
 }
 
-std::string MarkdownConverter::convert_tr(tinyxml2::XMLElement* el, const std::string& text,
-                                         const std::unordered_set<std::string>& parent_tags) {
-    return "| " + text + "\n";
 }
 
-std::string MarkdownConverter::convert_td(tinyxml2::XMLElement* el, const std::string& text,
-                                         const std::unordered_set<std::string>& parent_tags) {
-    return text + " | ";
+// td and th.
+void MarkdownConverter::close_cell(Frame& frame, const ParentContext& context,
+                                   MarkdownWriter& out) const {
+    if (!context.table) {
+        out.append(" | ");
+        return;
+    }
+
+    const HtmlNode* el = frame.element;
+    std::size_t colspan = 1;
+    std::size_t rowspan = 1;
+    detail::ColumnAlign align = detail::ColumnAlign::NONE;
+    if (el->attribute_count > 0) {
+        colspan = span_attribute(el, "colspan", 1000);
+        rowspan = span_attribute(el, "rowspan", 65534);
+        align = cell_align(el);
+    }
+    context.table->add_cell(out.view(frame.start), el->tag == TagId::TH, colspan, rowspan,
+                            align);
+    out.truncate(frame.start);
 }
 
-std::string MarkdownConverter::convert_th(tinyxml2::XMLElement* el, const std::string& text,
-                                         const std::unordered_set<std::string>& parent_tags) {
-    return text + " | ";
+void MarkdownConverter::close_custom(Frame& frame, const ParentContext& context,
+                                     MarkdownWriter& out) const {
+    const HtmlNode* element = frame.element;
+    const CustomHandler* handler = nullptr;
+    if (element->tag != TagId::UNKNOWN) {
+        handler = &custom_handlers_[custom_index_[tag_index(element->tag)] - 1].second;
+    } else {
+        auto found = std::lower_bound(custom_handlers_.begin(), custom_handlers_.end(),
+                                      element->name,
+                                      [](const auto& entry, std::string_view name) {
+                                          return entry.first < name;
+                                      });
+        if (found == custom_handlers_.end() || found->first != element->name) {
+            return;
+        }
+        handler = &found->second;
+    }
+
+    std::string& children = out.scratch();
+    children.assign(out.view(frame.start));
+    out.truncate(frame.start);
+    (*handler)(*element, children, context, out);
+
+    if (element->tag == TagId::TD || element->tag == TagId::TH) {
+        close_cell(frame, context, out);
+    }
 }
 
-std::string MarkdownConverter::strip_document(const std::string& text) {
-    std::string result = text;
+void MarkdownConverter::StripBoundary::push(std::string_view markdown, const Sink& sink) {
+    auto is_space = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
 
-    if (options_.strip_document == StripMode::LSTRIP ||
-        options_.strip_document == StripMode::STRIP) {
-        result = trim_left(result);
+    if (!started_ && (mode_ == StripMode::LSTRIP || mode_ == StripMode::STRIP)) {
+        std::size_t start = 0;
+        while (start < markdown.size() && is_space(markdown[start])) ++start;
+        markdown.remove_prefix(start);
     }
+    if (markdown.empty()) {
+        return;
+    }
+    started_ = true;
 
-    if (options_.strip_document == StripMode::RSTRIP ||
-        options_.strip_document == StripMode::STRIP) {
-        result = trim_right(result);
+    if (mode_ != StripMode::RSTRIP && mode_ != StripMode::STRIP) {
+        sink(markdown);
+        return;
     }
 
-    return result;
+    std::size_t end = markdown.size();
+    while (end > 0 && is_space(markdown[end - 1])) --end;
+    if (end == 0) {
+        held_.append(markdown.data(), markdown.size());
+        return;
+    }
+
+    if (!held_.empty()) {
+        sink(held_);
+    }
+    sink(markdown.substr(0, end));
+    held_.assign(markdown.data() + end, markdown.size() - end);
+}
+
+void MarkdownConverter::StripBoundary::reset() {
+    held_.clear();
+    started_ = false;
+}
+
+void MarkdownConverter::strip_document(std::string& text) const {
+    auto is_space = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
+
+    if (options().strip_document == StripMode::RSTRIP ||
+        options().strip_document == StripMode::STRIP) {
+        std::size_t end = text.size();
+        while (end > 0 && is_space(text[end - 1])) --end;
+        text.resize(end);
+    }
+
+    if (options().strip_document == StripMode::LSTRIP ||
+        options().strip_document == StripMode::STRIP) {
+        std::size_t begin = 0;
+        while (begin < text.size() && is_space(text[begin])) ++begin;
+        text.erase(0, begin);
+    }
 }
 
 }
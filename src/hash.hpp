@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace markdownify {
+namespace detail {
+
+struct Hash128 {
+    std::uint64_t low = 0;
+    std::uint64_t high = 0;
+
+    bool operator==(const Hash128& other) const {
+        return low == other.low && high == other.high;
+    }
+    bool operator!=(const Hash128& other) const { return !(*this == other); }
+};
+
+// For unordered containers keyed by a Hash128: the low half is already
+// well mixed.
+struct Hash128Hasher {
+    std::size_t operator()(const Hash128& hash) const {
+        return static_cast<std::size_t>(hash.low);
+    }
+};
+
+// Incremental 128-bit hash of a sequence of words and byte strings. Two
+// independently mixed 64-bit lanes, finalized with the MurmurHash3 mixer.
+// Fast rather than cryptographic: it tells apart inputs that differ by
+// accident, not ones crafted to collide.
+class Hasher {
+public:
+    explicit Hasher(std::uint64_t seed = 0)
+        : a_(seed ^ 0x243F6A8885A308D3ull), b_(~seed ^ 0x13198A2E03707344ull) {
+    }
+
+    void add(std::uint64_t value) {
+        a_ = rotl((a_ ^ value) * kMulA, 31);
+        b_ = (b_ + value) * kMulB;
+        b_ ^= b_ >> 29;
+        ++count_;
+    }
+
+    // Length-prefixed, so that consecutive strings cannot run together.
+    void add(std::string_view bytes) {
+        add(static_cast<std::uint64_t>(bytes.size()));
+        const char* data = bytes.data();
+        std::size_t size = bytes.size();
+        while (size >= 8) {
+            std::uint64_t word;
+            std::memcpy(&word, data, 8);
+            add(word);
+            data += 8;
+            size -= 8;
+        }
+        if (size > 0) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, data, size);
+            add(word);
+        }
+    }
+
+    void add(const Hash128& hash) {
+        add(hash.low);
+        add(hash.high);
+    }
+
+    Hash128 finish() const {
+        Hash128 hash;
+        hash.low = mix(a_ + rotl(b_, 17) + count_);
+        hash.high = mix(b_ ^ rotl(a_, 41) ^ (count_ * kMulA));
+        return hash;
+    }
+
+private:
+    static constexpr std::uint64_t kMulA = 0x9E3779B97F4A7C15ull;
+    static constexpr std::uint64_t kMulB = 0xC2B2AE3D27D4EB4Full;
+
+    std::uint64_t a_;
+    std::uint64_t b_;
+    std::uint64_t count_ = 0;
+
+    static std::uint64_t rotl(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    static std::uint64_t mix(std::uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDull;
+        x ^= x >> 33;
+        x *= 0xC4CEB93FE1A85EC3ull;
+        x ^= x >> 33;
+        return x;
+    }
+};
+
+inline Hash128 hash_bytes(std::string_view bytes) {
+    Hasher hasher;
+    hasher.add(bytes);
+    return hasher.finish();
+}
+
+}
+}
@@ -0,0 +1,968 @@
+#include "markdownify/html_parser.hpp"
+#include "html_entities.hpp"
+#include "simd_scan.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace markdownify {
+
+namespace {
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+bool is_alpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool equals_ignore_case(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (to_lower(a[i]) != to_lower(b[i])) return false;
+    }
+    return true;
+}
+
+bool is_heading(TagId tag) {
+    return tag >= TagId::H1 && tag <= TagId::H6;
+}
+
+bool is_void(TagId tag, std::string_view name) {
+    switch (tag) {
+    case TagId::AREA: case TagId::BASE: case TagId::BR: case TagId::COL: case TagId::EMBED:
+    case TagId::HR: case TagId::IMG: case TagId::INPUT: case TagId::LINK: case TagId::META:
+    case TagId::PARAM: case TagId::SOURCE: case TagId::TRACK: case TagId::WBR:
+        return true;
+    case TagId::UNKNOWN:
+        return name == "keygen";
+    default:
+        return false;
+    }
+}
+
+// Start tags that implicitly close an open <p>.
+bool closes_paragraph(TagId tag, std::string_view name) {
+    switch (tag) {
+    case TagId::ADDRESS: case TagId::ARTICLE: case TagId::ASIDE: case TagId::BLOCKQUOTE:
+    case TagId::DETAILS: case TagId::DIALOG: case TagId::DIV: case TagId::DL: case TagId::DD:
+    case TagId::DT: case TagId::FIELDSET: case TagId::FIGCAPTION: case TagId::FIGURE:
+    case TagId::FOOTER: case TagId::FORM: case TagId::H1: case TagId::H2: case TagId::H3:
+    case TagId::H4: case TagId::H5: case TagId::H6: case TagId::HEADER: case TagId::HGROUP:
+    case TagId::HR: case TagId::LI: case TagId::MAIN: case TagId::MENU: case TagId::NAV:
+    case TagId::OL: case TagId::P: case TagId::PRE: case TagId::SECTION: case TagId::SUMMARY:
+    case TagId::TABLE: case TagId::UL:
+        return true;
+    case TagId::UNKNOWN:
+        return name == "center" || name == "dir" || name == "listing";
+    default:
+        return false;
+    }
+}
+
+// Windows-1252 mappings for numeric references in 0x80-0x9F.
+const unsigned short kC1Replacements[32] = {
+    0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+    0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+};
+
+void append_utf8(std::string& out, unsigned long cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Decodes a numeric character reference starting after "&#". Returns the
+// number of bytes consumed, or 0 if there is no valid reference.
+std::size_t decode_numeric(std::string_view text, std::size_t pos, std::string& out) {
+    std::size_t p = pos;
+    bool hex = false;
+    if (p < text.size() && (text[p] == 'x' || text[p] == 'X')) {
+        hex = true;
+        ++p;
+    }
+
+    std::size_t digits_start = p;
+    unsigned long cp = 0;
+    while (p < text.size()) {
+        char c = text[p];
+        int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (hex && c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (hex && c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            break;
+        }
+        if (cp <= 0x10FFFF) {
+            cp = cp * (hex ? 16 : 10) + digit;
+        }
+        ++p;
+    }
+
+    if (p == digits_start) {
+        return 0;
+    }
+    if (p < text.size() && text[p] == ';') {
+        ++p;
+    }
+
+    if (cp == 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        cp = 0xFFFD;
+    } else if (cp >= 0x80 && cp <= 0x9F) {
+        cp = kC1Replacements[cp - 0x80];
+    }
+    append_utf8(out, cp);
+    return p - pos;
+}
+
+bool is_alnum(char c) {
+    return is_alpha(c) || (c >= '0' && c <= '9');
+}
+
+// Decodes a named character reference starting after "&". Returns the
+// number of bytes consumed, or 0 if there is no valid reference. A legacy
+// name may be followed by more letters ("&notit;" reads as "&not;it;"),
+// except in attribute values, where it is then left as it is.
+std::size_t decode_named(std::string_view text, std::size_t pos, std::string& out,
+                         bool in_attribute) {
+    std::size_t end = pos;
+    while (end < text.size() && end - pos < detail::kMaxEntityLength && is_alnum(text[end])) {
+        ++end;
+    }
+    if (end == pos) {
+        return 0;
+    }
+    if (end < text.size() && text[end] == ';') {
+        std::string_view value = detail::lookup_entity(text.substr(pos, end + 1 - pos));
+        if (!value.empty()) {
+            out.append(value.data(), value.size());
+            return end + 1 - pos;
+        }
+    }
+
+    for (std::size_t length = std::min(end - pos, detail::kMaxLegacyEntityLength); length > 1;
+         --length) {
+        std::string_view value = detail::lookup_entity(text.substr(pos, length));
+        if (value.empty()) {
+            continue;
+        }
+        std::size_t next = pos + length;
+        if (in_attribute && next < text.size() && (text[next] == '=' || is_alnum(text[next]))) {
+            return 0;
+        }
+        out.append(value.data(), value.size());
+        return length;
+    }
+    return 0;
+}
+
+// Position of the first '&' or '\r' in text from pos on, or npos.
+std::size_t find_reference(std::string_view text, std::size_t pos = 0) {
+    static const detail::ByteSet kReferenceStart("&\r");
+    std::size_t hit = pos + detail::find_first_in_set(text.data() + pos, text.size() - pos,
+                                                      kReferenceStart);
+    return hit < text.size() ? hit : std::string_view::npos;
+}
+
+}
+
+const HtmlAttribute* HtmlNode::find_attribute(std::string_view attr_name) const {
+    for (std::size_t i = 0; i < attribute_count; ++i) {
+        if (attributes[i].name == attr_name) {
+            return &attributes[i];
+        }
+    }
+    return nullptr;
+}
+
+const HtmlNode* HtmlNode::first_child_element(std::string_view tag) const {
+    for (const HtmlNode* child = first_child; child; child = child->next_sibling) {
+        if (child->is_element() && (tag.empty() || child->name == tag)) {
+            return child;
+        }
+    }
+    return nullptr;
+}
+
+const HtmlNode* HtmlNode::next_sibling_element(std::string_view tag) const {
+    for (const HtmlNode* sibling = next_sibling; sibling; sibling = sibling->next_sibling) {
+        if (sibling->is_element() && (tag.empty() || sibling->name == tag)) {
+            return sibling;
+        }
+    }
+    return nullptr;
+}
+
+HtmlDocument::HtmlDocument() {
+    clear();
+}
+
+void HtmlDocument::clear() {
+    nodes_.reset();
+    attributes_.reset();
+    strings_.reset();
+    node_count_ = 1;
+    root_ = nodes_.allocate();
+    root_->type = HtmlNodeType::DOCUMENT;
+}
+
+HtmlNode* HtmlDocument::create_element(std::string_view name) {
+    ++node_count_;
+    HtmlNode* node = nodes_.allocate();
+    node->type = HtmlNodeType::ELEMENT;
+    node->name = name;
+    node->tag = lookup_tag(name);
+    return node;
+}
+
+HtmlNode* HtmlDocument::create_text(std::string_view value) {
+    ++node_count_;
+    HtmlNode* node = nodes_.allocate();
+    node->type = HtmlNodeType::TEXT;
+    node->value = value;
+    return node;
+}
+
+HtmlAttribute* HtmlDocument::create_attributes(std::size_t count) {
+    return count ? attributes_.allocate(count) : nullptr;
+}
+
+void HtmlDocument::append_child(HtmlNode* parent, HtmlNode* child) {
+    child->parent = parent;
+    child->prev_sibling = parent->last_child;
+    if (parent->last_child) {
+        parent->last_child->next_sibling = child;
+    } else {
+        parent->first_child = child;
+    }
+    parent->last_child = child;
+}
+
+void decode_entities(std::string_view text, std::string& out, bool in_attribute) {
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t special = find_reference(text, pos);
+        if (special == std::string_view::npos) {
+            out.append(text.data() + pos, text.size() - pos);
+            return;
+        }
+        out.append(text.data() + pos, special - pos);
+        pos = special + 1;
+
+        if (text[special] == '\r') {
+            out += '\n';
+            if (pos < text.size() && text[pos] == '\n') {
+                ++pos;
+            }
+            continue;
+        }
+
+        std::size_t consumed = 0;
+        if (pos < text.size() && text[pos] == '#') {
+            consumed = decode_numeric(text, pos + 1, out);
+            if (consumed) ++consumed;
+        } else {
+            consumed = decode_named(text, pos, out, in_attribute);
+        }
+
+        if (consumed) {
+            pos += consumed;
+        } else {
+            out += '&';
+        }
+    }
+}
+
+bool is_void_element(std::string_view tag) {
+    return is_void(lookup_tag(tag), tag);
+}
+
+HtmlParser::HtmlParser(HtmlDocument& doc)
+    : doc_(doc) {
+    reset();
+}
+
+void HtmlParser::reset() {
+    HtmlNode* root = doc_.root();
+    rebase(&root, 1);
+    text_buffer_.clear();
+    borrowed_text_ = std::string_view();
+    pending_.clear();
+    raw_text_tag_ = nullptr;
+}
+
+void HtmlParser::parse(std::string_view html) {
+    reset();
+    consume(html, true);
+    flush_text();
+}
+
+void HtmlParser::parse_in_place(std::string_view html) {
+    borrow_input_ = true;
+    parse(html);
+    borrow_input_ = false;
+}
+
+void HtmlParser::feed(std::string_view chunk) {
+    if (pending_.empty()) {
+        std::size_t consumed = consume(chunk, false);
+        pending_.assign(chunk.data() + consumed, chunk.size() - consumed);
+        return;
+    }
+
+    pending_.append(chunk.data(), chunk.size());
+    std::size_t consumed = consume(pending_, false);
+    pending_.erase(0, consumed);
+}
+
+void HtmlParser::finish() {
+    consume(pending_, true);
+    pending_.clear();
+    flush_text();
+    pop_open_to(1);
+    raw_text_tag_ = nullptr;
+}
+
+void HtmlParser::rebase(HtmlNode* const* open_elements, std::size_t count) {
+    open_elements_.assign(open_elements, open_elements + 1);
+    open_links_.assign(1, OpenLink());
+    last_open_.fill(0);
+    last_open_unknown_.clear();
+    for (std::size_t i = 1; i < count; ++i) {
+        push_open(open_elements[i]);
+    }
+}
+
+// Returns the end of the longest prefix of [pos, end) that can be decoded
+// without seeing more input: a character reference or a CR LF pair may
+// continue past the end of the chunk.
+std::size_t HtmlParser::safe_text_end(std::string_view input, std::size_t pos,
+                                      std::size_t end) {
+    std::size_t window = end - pos > 64 ? end - 64 : pos;
+    std::size_t amp = input.substr(0, end).rfind('&');
+    if (amp != std::string_view::npos && amp >= window) {
+        end = amp;
+    }
+    if (end > pos && input[end - 1] == '\r') {
+        --end;
+    }
+    return end;
+}
+
+std::size_t HtmlParser::consume(std::string_view html, bool final) {
+    std::size_t pos = 0;
+    const std::size_t n = html.size();
+
+    while (pos < n) {
+        if (raw_text_tag_) {
+            std::size_t next = parse_raw_text(html, pos, final);
+            if (next == kIncomplete) {
+                return pos;
+            }
+            pos = next;
+            continue;
+        }
+
+        const void* found = std::memchr(html.data() + pos, '<', n - pos);
+        if (!found) {
+            std::size_t end = final ? n : safe_text_end(html, pos, n);
+            add_text(html.substr(pos, end - pos), true);
+            return end;
+        }
+
+        std::size_t lt = static_cast<const char*>(found) - html.data();
+        if (lt > pos) {
+            add_text(html.substr(pos, lt - pos), true);
+            pos = lt;
+        }
+
+        std::size_t next = parse_markup(html, lt, final);
+        if (next == kIncomplete) {
+            return pos;
+        }
+        pos = next;
+    }
+
+    return pos;
+}
+
+std::size_t HtmlParser::parse_markup(std::string_view html, std::size_t lt, bool final) {
+    const std::size_t n = html.size();
+    if (lt + 1 >= n && !final) {
+        return kIncomplete;
+    }
+
+    char next = lt + 1 < n ? html[lt + 1] : '\0';
+    if (is_alpha(next)) {
+        return parse_start_tag(html, lt, final);
+    }
+
+    if (next == '/') {
+        if (lt + 2 >= n && !final) {
+            return kIncomplete;
+        }
+        char after = lt + 2 < n ? html[lt + 2] : '\0';
+        if (is_alpha(after)) {
+            return parse_end_tag(html, lt, final);
+        }
+        if (after == '>') {
+            return lt + 3;
+        }
+        return skip_past(html, lt + 2, ">", final);
+    }
+
+    if (next == '!') {
+        if (n - lt < 4 && !final && std::string_view("<!--").substr(0, n - lt) == html.substr(lt)) {
+            return kIncomplete;
+        }
+        if (html.compare(lt, 4, "<!--") == 0) {
+            if (n - lt < 6 && !final) {
+                return kIncomplete;
+            }
+            if (html.compare(lt, 5, "<!-->") == 0) {
+                return lt + 5;
+            }
+            if (html.compare(lt, 6, "<!--->") == 0) {
+                return lt + 6;
+            }
+            return skip_past(html, lt + 4, "-->", final);
+        }
+        return skip_past(html, lt + 2, ">", final);
+    }
+
+    if (next == '?') {
+        return skip_past(html, lt + 2, ">", final);
+    }
+
+    unborrow_text();
+    text_buffer_ += '<';
+    return lt + 1;
+}
+
+std::size_t HtmlParser::skip_past(std::string_view html, std::size_t pos,
+                                  std::string_view terminator, bool final) {
+    std::size_t end = html.find(terminator, pos);
+    if (end == std::string_view::npos) {
+        return final ? html.size() : kIncomplete;
+    }
+    return end + terminator.size();
+}
+
+std::size_t HtmlParser::parse_start_tag(std::string_view html, std::size_t pos, bool final) {
+    const std::size_t n = html.size();
+    std::size_t p = pos + 1;
+
+    // A tag cut off by the end of input is dropped.
+    const std::size_t cut_off = final ? n : kIncomplete;
+
+    name_buffer_.clear();
+    while (p < n && !is_space(html[p]) && html[p] != '/' && html[p] != '>') {
+        name_buffer_ += to_lower(html[p]);
+        ++p;
+    }
+    tag_buffer_ = name_buffer_;
+
+    attribute_text_.clear();
+    attribute_spans_.clear();
+    bool self_closing = false;
+    for (;;) {
+        while (p < n && is_space(html[p])) ++p;
+        if (p >= n) {
+            return cut_off;
+        }
+        if (html[p] == '>') {
+            ++p;
+            break;
+        }
+        if (html[p] == '/') {
+            ++p;
+            if (p < n && html[p] == '>') {
+                self_closing = true;
+                ++p;
+                break;
+            }
+            continue;
+        }
+
+        AttributeSpan span;
+        span.name_offset = attribute_text_.size();
+        attribute_text_ += to_lower(html[p++]);
+        while (p < n && !is_space(html[p]) && html[p] != '/' &&
+               html[p] != '>' && html[p] != '=') {
+            attribute_text_ += to_lower(html[p]);
+            ++p;
+        }
+        span.name_length = attribute_text_.size() - span.name_offset;
+        while (p < n && is_space(html[p])) ++p;
+
+        span.value_offset = attribute_text_.size();
+        if (p < n && html[p] == '=') {
+            ++p;
+            while (p < n && is_space(html[p])) ++p;
+            std::string_view raw;
+            if (p < n && (html[p] == '"' || html[p] == '\'')) {
+                char quote = html[p++];
+                std::size_t end = html.find(quote, p);
+                if (end == std::string_view::npos) {
+                    return cut_off;
+                }
+                raw = html.substr(p, end - p);
+                p = end + 1;
+            } else {
+                std::size_t start = p;
+                while (p < n && !is_space(html[p]) && html[p] != '>') ++p;
+                if (p >= n) {
+                    return cut_off;
+                }
+                raw = html.substr(start, p - start);
+            }
+            if (borrow_input_ && find_reference(raw) == std::string_view::npos) {
+                span.borrowed_value = raw;
+            } else {
+                decode_entities(raw, attribute_text_, true);
+            }
+        }
+        span.value_length = attribute_text_.size() - span.value_offset;
+        attribute_spans_.push_back(span);
+    }
+
+    attributes_.clear();
+    for (const auto& span : attribute_spans_) {
+        std::string_view attr_name(attribute_text_.data() + span.name_offset, span.name_length);
+        bool duplicate = false;
+        for (const auto& attr : attributes_) {
+            if (attr.name == attr_name) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate) {
+            std::string_view value = span.borrowed_value;
+            if (value.empty()) {
+                value = doc_.store(std::string_view(attribute_text_.data() + span.value_offset,
+                                                    span.value_length));
+            }
+            attributes_.push_back({doc_.store(attr_name), value});
+        }
+    }
+
+    std::string_view name = doc_.store(tag_buffer_);
+    insert_element(name, self_closing);
+
+    if (!self_closing) {
+        if (name == "script") {
+            raw_text_tag_ = "script";
+        } else if (name == "style") {
+            raw_text_tag_ = "style";
+        } else if (name == "title") {
+            raw_text_tag_ = "title";
+        } else if (name == "textarea") {
+            raw_text_tag_ = "textarea";
+        }
+        raw_text_decode_ = name == "title" || name == "textarea";
+    }
+    return p;
+}
+
+std::size_t HtmlParser::parse_end_tag(std::string_view html, std::size_t pos, bool final) {
+    const std::size_t n = html.size();
+    std::size_t p = pos + 2;
+
+    name_buffer_.clear();
+    while (p < n && !is_space(html[p]) && html[p] != '/' && html[p] != '>') {
+        name_buffer_ += to_lower(html[p]);
+        ++p;
+    }
+
+    std::size_t gt = html.find('>', p);
+    if (gt == std::string_view::npos) {
+        return final ? n : kIncomplete;
+    }
+
+    close_element(name_buffer_);
+    return gt + 1;
+}
+
+// Consumes raw text up to the matching end tag, which is left for the
+// regular end tag path. Without the end tag in sight, consumes what cannot
+// be part of it.
+std::size_t HtmlParser::parse_raw_text(std::string_view html, std::size_t pos, bool final) {
+    const std::size_t n = html.size();
+    const std::string_view tag(raw_text_tag_);
+    std::size_t search = pos;
+    std::size_t end = std::string_view::npos;
+
+    while (search < n) {
+        std::size_t lt = html.find("</", search);
+        if (lt == std::string_view::npos) {
+            break;
+        }
+        std::size_t after = lt + 2 + tag.size();
+        if (after < n && equals_ignore_case(html.substr(lt + 2, tag.size()), tag) &&
+            (is_space(html[after]) || html[after] == '/' || html[after] == '>')) {
+            end = lt;
+            break;
+        }
+        search = lt + 2;
+    }
+
+    bool complete = end != std::string_view::npos || final;
+    if (!complete) {
+        std::size_t keep = tag.size() + 3;
+        end = safe_text_end(html, pos, n - pos > keep ? n - keep : pos);
+    } else if (end == std::string_view::npos) {
+        end = n;
+    }
+
+    add_text(html.substr(pos, end - pos), raw_text_decode_);
+
+    if (!complete) {
+        return end == pos ? kIncomplete : end;
+    }
+
+    flush_text();
+    pop_open_to(open_elements_.size() - 1);
+    raw_text_tag_ = nullptr;
+    return end;
+}
+
+// Adds text to the pending text node, decoding character references if
+// decode is set and normalizing newlines either way. With parse_in_place(),
+// a text node made of a single run that needs neither keeps pointing into
+// the input.
+void HtmlParser::add_text(std::string_view text, bool decode) {
+    if (borrow_input_ && text_buffer_.empty() && borrowed_text_.empty() &&
+        (decode ? find_reference(text) : text.find('\r')) == std::string_view::npos) {
+        borrowed_text_ = text;
+        return;
+    }
+
+    unborrow_text();
+    if (decode) {
+        decode_entities(text, text_buffer_);
+        return;
+    }
+
+    std::size_t cr = text.find('\r');
+    if (cr == std::string_view::npos) {
+        text_buffer_.append(text.data(), text.size());
+        return;
+    }
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\r') {
+            text_buffer_ += '\n';
+            if (i + 1 < text.size() && text[i + 1] == '\n') ++i;
+        } else {
+            text_buffer_ += text[i];
+        }
+    }
+}
+
+void HtmlParser::unborrow_text() {
+    if (!borrowed_text_.empty()) {
+        text_buffer_.assign(borrowed_text_.data(), borrowed_text_.size());
+        borrowed_text_ = std::string_view();
+    }
+}
+
+void HtmlParser::flush_text() {
+    std::string_view value = borrowed_text_;
+    if (value.empty()) {
+        if (text_buffer_.empty()) {
+            return;
+        }
+        value = doc_.store(text_buffer_);
+    }
+    HtmlNode* text = doc_.create_text(value);
+    HtmlDocument::append_child(current_node(), text);
+    text_buffer_.clear();
+    borrowed_text_ = std::string_view();
+}
+
+void HtmlParser::insert_element(std::string_view name, bool self_closing) {
+    flush_text();
+    const TagId tag = lookup_tag(name);
+    close_implied_for(tag, name);
+
+    HtmlNode* element = doc_.create_element(name);
+    element->attribute_count = attributes_.size();
+    HtmlAttribute* attrs = doc_.create_attributes(attributes_.size());
+    std::copy(attributes_.begin(), attributes_.end(), attrs);
+    element->attributes = attrs;
+    HtmlDocument::append_child(current_node(), element);
+
+    if (!self_closing && !is_void(tag, name)) {
+        push_open(element);
+    }
+}
+
+void HtmlParser::close_implied_for(TagId tag, std::string_view name) {
+    if (closes_paragraph(tag, name)) {
+        close_in_scope(last_open(TagId::P), Scope::BUTTON);
+    }
+
+    switch (tag) {
+    case TagId::H1: case TagId::H2: case TagId::H3:
+    case TagId::H4: case TagId::H5: case TagId::H6:
+        if (open_elements_.size() > 1 && is_heading(current_node()->tag)) {
+            pop_open_to(open_elements_.size() - 1);
+        }
+        break;
+    case TagId::LI:
+        close_in_scope(last_open(TagId::LI), Scope::LIST_ITEM);
+        break;
+    case TagId::DT: case TagId::DD:
+        close_in_scope(last_open(TagId::DT), Scope::DEFINITION);
+        close_in_scope(last_open(TagId::DD), Scope::DEFINITION);
+        break;
+    case TagId::TD: case TagId::TH:
+        close_in_scope(last_open(TagId::TD), Scope::TABLE);
+        close_in_scope(last_open(TagId::TH), Scope::TABLE);
+        break;
+    case TagId::TR:
+        close_in_scope(last_open(TagId::TD), Scope::TABLE);
+        close_in_scope(last_open(TagId::TH), Scope::TABLE);
+        close_in_scope(last_open(TagId::TR), Scope::TABLE);
+        break;
+    case TagId::THEAD: case TagId::TBODY: case TagId::TFOOT:
+        close_in_scope(last_open(TagId::TD), Scope::TABLE);
+        close_in_scope(last_open(TagId::TH), Scope::TABLE);
+        close_in_scope(last_open(TagId::TR), Scope::TABLE);
+        close_in_scope(last_open(TagId::THEAD), Scope::TABLE);
+        close_in_scope(last_open(TagId::TBODY), Scope::TABLE);
+        close_in_scope(last_open(TagId::TFOOT), Scope::TABLE);
+        break;
+    case TagId::OPTION: case TagId::OPTGROUP:
+        if (current_node()->tag == TagId::OPTION) {
+            pop_open_to(open_elements_.size() - 1);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void HtmlParser::close_element(std::string_view name) {
+    flush_text();
+
+    const TagId tag = lookup_tag(name);
+    switch (tag) {
+    case TagId::BR:
+        attributes_.clear();
+        insert_element("br", true);
+        break;
+    case TagId::H1: case TagId::H2: case TagId::H3:
+    case TagId::H4: case TagId::H5: case TagId::H6: {
+        // Any open heading closes any other.
+        std::uint32_t heading = 0;
+        for (TagId id : {TagId::H1, TagId::H2, TagId::H3, TagId::H4, TagId::H5, TagId::H6}) {
+            heading = std::max(heading, last_open(id));
+        }
+        close_in_scope(heading, Scope::DEFAULT);
+        break;
+    }
+    case TagId::P:
+        close_in_scope(last_open(tag), Scope::BUTTON);
+        break;
+    case TagId::LI:
+        close_in_scope(last_open(tag), Scope::LIST_ITEM);
+        break;
+    case TagId::DT: case TagId::DD:
+        close_in_scope(last_open(tag), Scope::DEFINITION);
+        break;
+    case TagId::TABLE:
+        close_in_scope(last_open(tag), Scope::DOCUMENT);
+        break;
+    case TagId::TR: case TagId::TD: case TagId::TH: case TagId::THEAD: case TagId::TBODY:
+    case TagId::TFOOT: case TagId::CAPTION:
+        close_in_scope(last_open(tag), Scope::TABLE);
+        break;
+    default:
+        close_in_scope(last_open(tag, name), Scope::DEFAULT);
+        break;
+    }
+}
+
+// Pops the open element at index and everything above it, unless a
+// boundary of scope lies above it. An index of 0 means nothing to close.
+bool HtmlParser::close_in_scope(std::uint32_t index, Scope scope) {
+    const std::uint32_t boundary = open_links_.back().boundaries[static_cast<std::size_t>(scope)];
+    if (index == 0 || index < boundary) {
+        return false;
+    }
+    pop_open_to(index);
+    return true;
+}
+
+// Scopes in which an open element with this name is a boundary, as bits
+// indexed by Scope. applet and marquee are not interned.
+unsigned HtmlParser::boundary_mask(TagId tag, std::string_view name) {
+    constexpr auto bit = [](Scope scope) { return 1u << static_cast<unsigned>(scope); };
+    constexpr unsigned kSpecial =
+        bit(Scope::DEFAULT) | bit(Scope::BUTTON) | bit(Scope::LIST_ITEM) | bit(Scope::DEFINITION);
+
+    switch (tag) {
+    case TagId::HTML: case TagId::TEMPLATE:
+        return kSpecial | bit(Scope::TABLE) | bit(Scope::DOCUMENT);
+    case TagId::TABLE:
+        return kSpecial | bit(Scope::TABLE);
+    case TagId::CAPTION: case TagId::OBJECT: case TagId::TD: case TagId::TH:
+        return kSpecial;
+    case TagId::BUTTON:
+        return bit(Scope::BUTTON);
+    case TagId::OL: case TagId::UL:
+        return bit(Scope::LIST_ITEM);
+    case TagId::DL:
+        return bit(Scope::DEFINITION);
+    case TagId::UNKNOWN:
+        return name == "applet" || name == "marquee" ? kSpecial : 0;
+    default:
+        return 0;
+    }
+}
+
+std::uint32_t& HtmlParser::last_open_slot(const HtmlNode* node) {
+    if (node->tag != TagId::UNKNOWN) {
+        return last_open_[tag_index(node->tag)];
+    }
+    return last_open_unknown_[node->name];
+}
+
+std::uint32_t HtmlParser::last_open(TagId tag, std::string_view name) const {
+    if (tag != TagId::UNKNOWN) {
+        return last_open_[tag_index(tag)];
+    }
+    auto it = last_open_unknown_.find(name);
+    return it == last_open_unknown_.end() ? 0 : it->second;
+}
+
+void HtmlParser::push_open(HtmlNode* element) {
+    const auto index = static_cast<std::uint32_t>(open_elements_.size());
+    OpenLink link = open_links_.back();
+    const unsigned mask = boundary_mask(element->tag, element->name);
+    for (std::size_t scope = 0; scope < kScopeCount; ++scope) {
+        if (mask & (1u << scope)) {
+            link.boundaries[scope] = index;
+        }
+    }
+    std::uint32_t& last = last_open_slot(element);
+    link.previous = last;
+    last = index;
+
+    open_elements_.push_back(element);
+    open_links_.push_back(link);
+}
+
+// Never pops the document root at index 0.
+void HtmlParser::pop_open_to(std::size_t size) {
+    while (open_elements_.size() > std::max<std::size_t>(size, 1)) {
+        last_open_slot(open_elements_.back()) = open_links_.back().previous;
+        open_elements_.pop_back();
+        open_links_.pop_back();
+    }
+}
+
+namespace {
+
+void append_escaped(std::string& out, std::string_view text, bool attribute) {
+    for (char c : text) {
+        switch (c) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"':
+                if (attribute) {
+                    out += "&quot;";
+                } else {
+                    out += c;
+                }
+                break;
+            default: out += c;
+        }
+    }
+}
+
+void append_start_tag(std::string& out, const HtmlNode* node) {
+    out += '<';
+    out.append(node->name.data(), node->name.size());
+    for (std::size_t i = 0; i < node->attribute_count; ++i) {
+        out += ' ';
+        out.append(node->attributes[i].name.data(), node->attributes[i].name.size());
+        out += "=\"";
+        append_escaped(out, node->attributes[i].value, true);
+        out += '"';
+    }
+    out += '>';
+}
+
+void append_end_tag(std::string& out, const HtmlNode* node) {
+    if (is_void_element(node->name)) {
+        return;
+    }
+    out += "</";
+    out.append(node->name.data(), node->name.size());
+    out += '>';
+}
+
+}
+
+std::string to_html(const HtmlNode* node) {
+    std::string out;
+    if (!node) {
+        return out;
+    }
+
+    const HtmlNode* current = node;
+    for (;;) {
+        if (current->is_text()) {
+            append_escaped(out, current->value, false);
+        } else {
+            if (current->is_element()) {
+                append_start_tag(out, current);
+            }
+            if (current->first_child) {
+                current = current->first_child;
+                continue;
+            }
+            if (current->is_element()) {
+                append_end_tag(out, current);
+            }
+        }
+
+        while (current != node && !current->next_sibling) {
+            current = current->parent;
+            if (current->is_element()) {
+                append_end_tag(out, current);
+            }
+        }
+        if (current == node) {
+            break;
+        }
+        current = current->next_sibling;
+    }
+
+    return out;
+}
+
+}
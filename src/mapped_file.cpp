@@ -0,0 +1,97 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace markdownify {
+namespace detail {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+std::string_view MappedFile::view() const {
+    if (map_) {
+        return std::string_view(static_cast<const char*>(map_), size_);
+    }
+    return contents_;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    contents_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+void MappedFile::close() {
+    contents_.clear();
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* map = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ,
+                           MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            ::madvise(map, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+            map_ = map;
+            size_ = static_cast<std::size_t>(info.st_size);
+            ::close(fd);
+            return true;
+        }
+    }
+
+    char buffer[65536];
+    for (;;) {
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n == 0) {
+            break;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            ::close(fd);
+            return false;
+        }
+        contents_.append(buffer, static_cast<std::size_t>(n));
+    }
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close() {
+    if (map_) {
+        ::munmap(map_, size_);
+        map_ = nullptr;
+        size_ = 0;
+    }
+    contents_.clear();
+}
+
+#endif
+
+}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace markdownify {
+namespace detail {
+
+// Read-only contents of a whole file. Regular files are memory-mapped;
+// anything else (pipes, devices) is read into memory.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false if the file cannot be opened or read.
+    bool open(const std::string& path);
+
+    std::string_view view() const;
+
+private:
+    void* map_ = nullptr;
+    std::size_t size_ = 0;
+    std::string contents_;
+
+    void close();
+};
+
+}
+}
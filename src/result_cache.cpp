@@ -0,0 +1,137 @@
+#include "markdownify/result_cache.hpp"
+#include "hash.hpp"
+#include <list>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace markdownify {
+
+namespace {
+
+// Roughly what an entry costs besides its Markdown: the list node, the index
+// node and its bucket.
+constexpr std::size_t kEntryOverhead = 128;
+
+std::size_t entry_bytes(const std::string& markdown) {
+    return markdown.size() + kEntryOverhead;
+}
+
+// Seeds the hash that is compared on a hit, so that it is computed
+// independently of the key.
+constexpr std::uint64_t kCheckSeed = 0x5851F42D4C957F2Dull;
+
+detail::Hash128 check_hash(std::string_view html) {
+    detail::Hasher hasher(kCheckSeed);
+    hasher.add(html);
+    return hasher.finish();
+}
+
+}
+
+// Aligned so that the locks of neighbouring shards do not share a cache line.
+struct alignas(64) ResultCache::Shard {
+    struct Entry {
+        detail::Hash128 key;
+        // Compared on a hit, so that a key collision reads as a miss.
+        std::size_t html_size;
+        detail::Hash128 check;
+        std::string markdown;
+
+        bool matches(std::string_view html) const {
+            return html.size() == html_size && check_hash(html) == check;
+        }
+    };
+
+    std::mutex mutex;
+    // Most recently used first.
+    std::list<Entry> entries;
+    std::unordered_map<detail::Hash128, std::list<Entry>::iterator, detail::Hash128Hasher> index;
+    std::size_t bytes = 0;
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+};
+
+ResultCache::ResultCache(std::size_t capacity_bytes, std::size_t shard_count) {
+    std::size_t count = 1;
+    while (count < shard_count) {
+        count *= 2;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+    shard_capacity_ = capacity_bytes / count;
+}
+
+ResultCache::~ResultCache() = default;
+
+// The index buckets by the low half of the key, so the shard is picked by
+// the high half.
+ResultCache::Shard& ResultCache::shard(const detail::Hash128& key) {
+    return *shards_[static_cast<std::size_t>(key.high >> 32) & (shards_.size() - 1)];
+}
+
+std::optional<std::string> ResultCache::find(const detail::Hash128& key, std::string_view html) {
+    Shard& shard = this->shard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found == shard.index.end() || !found->second->matches(html)) {
+        ++shard.misses;
+        return std::nullopt;
+    }
+    ++shard.hits;
+    shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+    return found->second->markdown;
+}
+
+void ResultCache::insert(const detail::Hash128& key, std::string_view html,
+                         const std::string& markdown) {
+    std::size_t bytes = entry_bytes(markdown);
+    if (bytes > shard_capacity_) {
+        return;
+    }
+
+    Shard& shard = this->shard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // Another thread may have converted the same document meanwhile. A
+    // colliding document keeps the entry that was there first.
+    if (shard.index.count(key) > 0) {
+        return;
+    }
+
+    shard.entries.push_front({key, html.size(), check_hash(html), markdown});
+    shard.index.emplace(key, shard.entries.begin());
+    shard.bytes += bytes;
+    while (shard.bytes > shard_capacity_) {
+        Shard::Entry& oldest = shard.entries.back();
+        shard.bytes -= entry_bytes(oldest.markdown);
+        shard.index.erase(oldest.key);
+        shard.entries.pop_back();
+        ++shard.evictions;
+    }
+}
+
+ResultCacheStats ResultCache::stats() const {
+    ResultCacheStats stats;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.hits += shard->hits;
+        stats.misses += shard->misses;
+        stats.evictions += shard->evictions;
+        stats.entry_count += shard->entries.size();
+        stats.bytes += shard->bytes;
+    }
+    return stats;
+}
+
+void ResultCache::clear() {
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->entries.clear();
+        shard->index.clear();
+        shard->bytes = 0;
+    }
+}
+
+}
@@ -0,0 +1,41 @@
+#include "markdownify/session.hpp"
+#include "mapped_file.hpp"
+
+namespace markdownify {
+
+ConversionSession::ConversionSession(const Options& options)
+    : owned_converter_(std::make_unique<MarkdownConverter>(options)),
+      converter_(owned_converter_.get()),
+      parser_(doc_) {
+}
+
+ConversionSession::ConversionSession(const MarkdownConverter& converter)
+    : converter_(&converter),
+      parser_(doc_) {
+}
+
+std::string_view ConversionSession::convert(std::string_view html) {
+    doc_.clear();
+    parser_.parse_in_place(html);
+
+    out_.clear();
+    converter_->convert_into(doc_, out_, frames_);
+    return out_.view();
+}
+
+std::string_view ConversionSession::convert(std::string_view html, ConversionStats& stats) {
+    doc_.clear();
+    out_.clear();
+    converter_->convert_measured(html, doc_, parser_, out_, frames_, stats);
+    return out_.view();
+}
+
+std::optional<std::string_view> ConversionSession::convert_file(const std::string& path) {
+    detail::MappedFile file;
+    if (!file.open(path)) {
+        return std::nullopt;
+    }
+    return convert(file.view());
+}
+
+}
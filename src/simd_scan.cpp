@@ -0,0 +1,171 @@
+#include "simd_scan.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MARKDOWNIFY_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+namespace markdownify {
+namespace detail {
+
+ByteSet::ByteSet(std::string_view bytes) {
+    for (char c : bytes) {
+        add(static_cast<unsigned char>(c));
+    }
+}
+
+void ByteSet::add(unsigned char c) {
+    if (c >= 0x80 || contains(c)) {
+        return;
+    }
+    low_[c & 15] |= static_cast<std::uint8_t>(1u << (c >> 4));
+    members_[member_count_++] = c;
+}
+
+namespace {
+
+std::size_t find_scalar(const char* data, std::size_t size, const ByteSet& set) {
+    for (std::size_t i = 0; i < size; ++i) {
+        if (set.contains(static_cast<unsigned char>(data[i]))) {
+            return i;
+        }
+    }
+    return size;
+}
+
+#ifdef MARKDOWNIFY_X86_DISPATCH
+
+// SSE2 has no byte shuffle, so every member gets its own compare.
+std::size_t find_sse2(const char* data, std::size_t size, const ByteSet& set) {
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hits = _mm_setzero_si128();
+        for (std::size_t m = 0; m < set.member_count(); ++m) {
+            __m128i member = _mm_set1_epi8(static_cast<char>(set.members()[m]));
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, member));
+        }
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + find_scalar(data + i, size - i, set);
+}
+
+// Bit h of entry h, so that (low lookup & high lookup) is non-zero exactly
+// for members. High nibbles 8..15 map to 0.
+alignas(16) const std::uint8_t kHighNibbleBits[16] = {
+    1, 2, 4, 8, 16, 32, 64, 128, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+__attribute__((target("avx2")))
+std::size_t find_avx2(const char* data, std::size_t size, const ByteSet& set) {
+    const __m256i low_table = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(set.low_nibbles())));
+    const __m256i high_table = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(kHighNibbleBits)));
+    const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(chunk, nibble_mask));
+        __m256i high = _mm256_shuffle_epi8(
+            high_table, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble_mask));
+        __m256i misses = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), zero);
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(misses));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + find_scalar(data + i, size - i, set);
+}
+
+// Copies a 16-byte table into all four lanes. The unmasked broadcast (and
+// _mm512_shuffle_i32x4) start from an undefined vector that GCC 12 warns
+// about under -Wall; the zero-masking form with every lane selected does not.
+__attribute__((target("avx512bw")))
+__m512i broadcast_table(const std::uint8_t* table) {
+    return _mm512_maskz_broadcast_i32x4(
+        0xffff, _mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+}
+
+__attribute__((target("avx512bw")))
+std::size_t find_avx512(const char* data, std::size_t size, const ByteSet& set) {
+    const __m512i low_table = broadcast_table(set.low_nibbles());
+    const __m512i high_table = broadcast_table(kHighNibbleBits);
+    const __m512i nibble_mask = _mm512_set1_epi8(0x0f);
+
+    for (std::size_t i = 0; i < size; i += 64) {
+        // The tail is read with a masked load, which never touches bytes
+        // past the end.
+        std::size_t remaining = size - i;
+        __mmask64 valid = remaining >= 64 ? ~__mmask64(0) : (__mmask64(1) << remaining) - 1;
+        __m512i chunk = _mm512_maskz_loadu_epi8(valid, data + i);
+        __m512i low = _mm512_shuffle_epi8(low_table, _mm512_and_si512(chunk, nibble_mask));
+        __m512i high = _mm512_shuffle_epi8(
+            high_table, _mm512_and_si512(_mm512_srli_epi16(chunk, 4), nibble_mask));
+        __mmask64 hits = _mm512_mask_test_epi8_mask(valid, low, high);
+        if (hits != 0) {
+            return i + __builtin_ctzll(hits);
+        }
+    }
+    return size;
+}
+
+#endif
+
+SimdLevel detect() {
+#ifdef MARKDOWNIFY_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SimdLevel::SSE2;
+    }
+#endif
+    return SimdLevel::SCALAR;
+}
+
+using FindFunction = std::size_t (*)(const char*, std::size_t, const ByteSet&);
+
+FindFunction kernel_for(SimdLevel level) {
+    switch (level) {
+#ifdef MARKDOWNIFY_X86_DISPATCH
+        case SimdLevel::AVX512:
+            return find_avx512;
+        case SimdLevel::AVX2:
+            return find_avx2;
+        case SimdLevel::SSE2:
+            return find_sse2;
+#endif
+        default:
+            return find_scalar;
+    }
+}
+
+}
+
+SimdLevel detected_simd_level() {
+    static const SimdLevel level = detect();
+    return level;
+}
+
+std::size_t find_first_in_set(const char* data, std::size_t size, const ByteSet& set) {
+    static const FindFunction kernel = kernel_for(detected_simd_level());
+    return kernel(data, size, set);
+}
+
+std::size_t find_first_in_set(const char* data, std::size_t size, const ByteSet& set,
+                              SimdLevel level) {
+    return kernel_for(level)(data, size, set);
+}
+
+}
+}
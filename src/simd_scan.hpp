@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace markdownify {
+namespace detail {
+
+enum class SimdLevel {
+    SCALAR,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+// A set of ASCII bytes, stored as a nibble table: byte c is a member when
+// low_[c & 15] has bit (c >> 4) set. Bytes >= 0x80 are never members.
+class ByteSet {
+public:
+    ByteSet() = default;
+    explicit ByteSet(std::string_view bytes);
+
+    void add(unsigned char c);
+
+    bool contains(unsigned char c) const {
+        return c < 0x80 && (low_[c & 15] & (1u << (c >> 4))) != 0;
+    }
+
+    const std::uint8_t* low_nibbles() const { return low_; }
+    const unsigned char* members() const { return members_; }
+    std::size_t member_count() const { return member_count_; }
+
+private:
+    alignas(16) std::uint8_t low_[16] = {};
+    unsigned char members_[128] = {};
+    std::size_t member_count_ = 0;
+};
+
+// Best level supported by the running CPU, detected once.
+SimdLevel detected_simd_level();
+
+// Index of the first byte of data[0, size) that is in set, or size.
+std::size_t find_first_in_set(const char* data, std::size_t size, const ByteSet& set);
+
+// Same, forcing a kernel. level must not exceed detected_simd_level().
+std::size_t find_first_in_set(const char* data, std::size_t size, const ByteSet& set,
+                              SimdLevel level);
+
+}
+}
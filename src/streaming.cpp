@@ -0,0 +1,228 @@
+#include "markdownify/streaming.hpp"
+
+namespace markdownify {
+
+namespace {
+
+// Emitted nodes are released once the document holds this many nodes and
+// only transparent containers are open.
+constexpr std::size_t kCompactThreshold = 1024;
+
+constexpr std::size_t kNone = static_cast<std::size_t>(-1);
+
+}
+
+StreamingConverter::StreamingConverter(const Options& options)
+    : converter_(options),
+      parser_(doc_),
+      strip_(options.strip_document) {
+    reset();
+}
+
+std::string StreamingConverter::feed(std::string_view chunk) {
+    parser_.feed(chunk);
+    pump(false);
+
+    std::string result;
+    result.swap(output_);
+    return result;
+}
+
+std::string StreamingConverter::finish() {
+    parser_.finish();
+    pump(true);
+
+    std::string result;
+    result.swap(output_);
+    reset();
+    return result;
+}
+
+void StreamingConverter::reset() {
+    doc_.clear();
+    parser_.reset();
+    frontier_.clear();
+    frontier_.push_back({doc_.root(), nullptr});
+    output_.clear();
+    strip_.reset();
+}
+
+void StreamingConverter::pump(bool final) {
+    if (final) {
+        finish_frames(0);
+        return;
+    }
+
+    const auto& open = parser_.open_elements();
+    std::size_t level = 0;
+    for (;;) {
+        HtmlNode* open_child = level + 1 < open.size() ? open[level + 1] : nullptr;
+        if (frontier_.size() > level + 1 && frontier_[level + 1].node != open_child) {
+            finish_frames(level + 1);
+        }
+
+        Frame& frame = frontier_[level];
+        const HtmlNode* child = frame.last_emitted ? frame.last_emitted->next_sibling
+                                                   : frame.node->first_child;
+        for (; child && child != open_child; child = child->next_sibling) {
+            // Whitespace handling of a text node depends on its next sibling.
+            if (child->is_text() && !child->next_sibling) {
+                break;
+            }
+            emit_node(child);
+            frame.last_emitted = child;
+        }
+
+        if (child && child == open_child && converter_.is_transparent(open_child->tag)) {
+            if (frontier_.size() == level + 1) {
+                frontier_.push_back({open_child, nullptr});
+            }
+            ++level;
+            continue;
+        }
+        break;
+    }
+
+    if (doc_.node_count() > kCompactThreshold && quiescent()) {
+        compact();
+    }
+}
+
+// Emits the remaining children of frames [from, end), deepest first, and
+// marks each finished frame as emitted in its parent.
+void StreamingConverter::finish_frames(std::size_t from) {
+    for (std::size_t i = frontier_.size(); i-- > from;) {
+        const Frame& frame = frontier_[i];
+        const HtmlNode* child = frame.last_emitted ? frame.last_emitted->next_sibling
+                                                   : frame.node->first_child;
+        for (; child; child = child->next_sibling) {
+            emit_node(child);
+        }
+        if (i > 0) {
+            frontier_[i - 1].last_emitted = frame.node;
+        }
+        frontier_.pop_back();
+    }
+}
+
+void StreamingConverter::emit_node(const HtmlNode* node) {
+    block_.clear();
+    converter_.walk(node, ParentContext(), frames_, block_);
+    emit(block_.view());
+}
+
+void StreamingConverter::emit(std::string_view markdown) {
+    strip_.push(markdown, [this](std::string_view piece) { output_.append(piece); });
+}
+
+// True when every open element is a frame and everything before the
+// innermost open point has been emitted.
+bool StreamingConverter::quiescent() const {
+    if (parser_.open_elements().size() != frontier_.size()) {
+        return false;
+    }
+    const Frame& frame = frontier_.back();
+    const HtmlNode* next = frame.last_emitted ? frame.last_emitted->next_sibling
+                                              : frame.node->first_child;
+    return !next || (next->is_text() && !next->next_sibling);
+}
+
+// Rebuilds the document with only the open frames, a childless stand-in for
+// the last emitted node of each frame (its name still matters for the
+// whitespace rules of the next text node) and the unemitted trailing text.
+void StreamingConverter::compact() {
+    saved_text_.clear();
+    saved_nodes_.clear();
+    saved_attributes_.clear();
+
+    std::vector<std::size_t> levels;
+    levels.reserve(frontier_.size() * 2 + 1);
+    for (std::size_t i = 0; i < frontier_.size(); ++i) {
+        levels.push_back(i == 0 ? kNone : save(frontier_[i].node));
+        levels.push_back(frontier_[i].last_emitted ? save(frontier_[i].last_emitted) : kNone);
+    }
+    const Frame& innermost = frontier_.back();
+    const HtmlNode* pending = innermost.last_emitted ? innermost.last_emitted->next_sibling
+                                                     : innermost.node->first_child;
+    std::size_t pending_saved = pending ? save(pending) : kNone;
+
+    doc_.clear();
+    rebuilt_.clear();
+
+    HtmlNode* parent = doc_.root();
+    for (std::size_t i = 0; i < frontier_.size(); ++i) {
+        if (i > 0) {
+            HtmlNode* element = restore(saved_nodes_[levels[i * 2]]);
+            HtmlDocument::append_child(parent, element);
+            parent = element;
+        }
+        rebuilt_.push_back(parent);
+        frontier_[i].node = parent;
+
+        frontier_[i].last_emitted = nullptr;
+        if (levels[i * 2 + 1] != kNone) {
+            HtmlNode* stand_in = restore(saved_nodes_[levels[i * 2 + 1]]);
+            if (stand_in->is_text()) {
+                stand_in->value = std::string_view();
+            }
+            stand_in->attributes = nullptr;
+            stand_in->attribute_count = 0;
+            HtmlDocument::append_child(parent, stand_in);
+            frontier_[i].last_emitted = stand_in;
+        }
+    }
+    if (pending_saved != kNone) {
+        HtmlDocument::append_child(parent, restore(saved_nodes_[pending_saved]));
+    }
+
+    parser_.rebase(rebuilt_.data(), rebuilt_.size());
+}
+
+std::size_t StreamingConverter::save(const HtmlNode* node) {
+    SavedNode saved;
+    saved.type = node->type;
+    std::string_view text = node->is_text() ? node->value : node->name;
+    saved.name_offset = saved_text_.size();
+    saved.name_length = text.size();
+    saved_text_.append(text.data(), text.size());
+
+    saved.attribute_begin = saved_attributes_.size();
+    saved.attribute_count = node->attribute_count;
+    for (std::size_t i = 0; i < node->attribute_count; ++i) {
+        const HtmlAttribute& attr = node->attributes[i];
+        SavedAttribute saved_attr;
+        saved_attr.name_offset = saved_text_.size();
+        saved_attr.name_length = attr.name.size();
+        saved_text_.append(attr.name.data(), attr.name.size());
+        saved_attr.value_offset = saved_text_.size();
+        saved_attr.value_length = attr.value.size();
+        saved_text_.append(attr.value.data(), attr.value.size());
+        saved_attributes_.push_back(saved_attr);
+    }
+
+    saved_nodes_.push_back(saved);
+    return saved_nodes_.size() - 1;
+}
+
+HtmlNode* StreamingConverter::restore(const SavedNode& saved) {
+    std::string_view text = doc_.store(
+        std::string_view(saved_text_).substr(saved.name_offset, saved.name_length));
+    if (saved.type == HtmlNodeType::TEXT) {
+        return doc_.create_text(text);
+    }
+
+    HtmlNode* element = doc_.create_element(text);
+    HtmlAttribute* attrs = doc_.create_attributes(saved.attribute_count);
+    for (std::size_t i = 0; i < saved.attribute_count; ++i) {
+        const SavedAttribute& saved_attr = saved_attributes_[saved.attribute_begin + i];
+        attrs[i].name = doc_.store(
+            std::string_view(saved_text_).substr(saved_attr.name_offset, saved_attr.name_length));
+        attrs[i].value = doc_.store(
+            std::string_view(saved_text_).substr(saved_attr.value_offset, saved_attr.value_length));
+    }
+    element->attributes = attrs;
+    element->attribute_count = saved.attribute_count;
+    return element;
+}
+
+}
@@ -0,0 +1,278 @@
+#include "subtree_memo.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace markdownify {
+namespace detail {
+
+namespace {
+
+constexpr std::uint64_t kElementWord = 1ull << 63;
+constexpr std::uint64_t kChildWord = 1ull << 62;
+
+// A node's own markup, excluding its children. Leaves are added to their
+// parent's hash this way rather than hashed on their own; the first word
+// tells the kinds apart, and everything after it is length-prefixed or of
+// fixed size, so different sequences of children cannot hash alike.
+void add_node(Hasher& hasher, const HtmlNode* node) {
+    if (!node->is_element()) {
+        hasher.add(node->value);
+        return;
+    }
+    hasher.add(kElementWord | static_cast<std::uint64_t>(node->tag) << 32 |
+               static_cast<std::uint64_t>(node->attribute_count));
+    if (node->tag == TagId::UNKNOWN) {
+        hasher.add(node->name);
+    }
+    for (std::size_t i = 0; i < node->attribute_count; ++i) {
+        hasher.add(node->attributes[i].name);
+        hasher.add(node->attributes[i].value);
+    }
+}
+
+bool feeds_table(TagId tag) {
+    return tag == TagId::TR || tag == TagId::TD || tag == TagId::TH;
+}
+
+}
+
+void SubtreeMemo::begin(const void* owner, std::uint64_t version, const HtmlDocument& doc,
+                        bool depth_matters) {
+    if (owner != owner_ || version != version_) {
+        previous_.clear();
+    }
+    owner_ = owner;
+    version_ = version;
+    depth_matters_ = depth_matters;
+    current_.clear();
+    pending_.clear();
+    reused_count_ = 0;
+    stored_count_ = 0;
+    std::fill(slots_.begin(), slots_.end(), Slot{nullptr, Summary()});
+    summary_count_ = 0;
+
+    // Post-order over the tree, through the parent links: a node is hashed
+    // once all of its children are.
+    const HtmlNode* root = doc.root();
+    const HtmlNode* node = root ? root->first_child : nullptr;
+    while (node) {
+        if (node->first_child) {
+            open_.push_back({node, Hasher(), 1, node->tag == TagId::LI, feeds_table(node->tag)});
+            add_node(open_.back().hasher, node);
+            node = node->first_child;
+            continue;
+        }
+
+        if (!open_.empty()) {
+            Open& parent = open_.back();
+            add_node(parent.hasher, node);
+            ++parent.nodes;
+            parent.counts_items = parent.counts_items || node->tag == TagId::LI;
+            parent.feeds_table = parent.feeds_table || feeds_table(node->tag);
+        }
+        while (!node->next_sibling) {
+            node = node->parent;
+            if (node == root) {
+                break;
+            }
+            close_node();
+        }
+        node = node == root ? nullptr : node->next_sibling;
+    }
+}
+
+// A nested ol numbers its own items and a nested table collects its own
+// cells, so neither is affected by or affects the enclosing ones.
+void SubtreeMemo::close_node() {
+    Open open = open_.back();
+    open_.pop_back();
+
+    Hash128 hash = open.hasher.finish();
+    TagId tag = open.node->tag;
+    Summary summary{hash, open.counts_items && tag != TagId::OL,
+                    open.feeds_table && tag != TagId::TABLE};
+    if (open.node->is_element() && open.nodes >= kMinNodes) {
+        add_summary(open.node, summary);
+    }
+    if (open_.empty()) {
+        return;
+    }
+
+    Open& parent = open_.back();
+    parent.hasher.add(kChildWord);
+    parent.hasher.add(hash);
+    parent.nodes += open.nodes;
+    parent.counts_items = parent.counts_items || summary.counts_items;
+    parent.feeds_table = parent.feeds_table || summary.feeds_table;
+}
+
+std::size_t SubtreeMemo::slot_of(const HtmlNode* node) const {
+    std::uint64_t address = reinterpret_cast<std::uintptr_t>(node);
+    return static_cast<std::size_t>((address * 0x9E3779B97F4A7C15ull) >> 32) &
+           (slots_.size() - 1);
+}
+
+void SubtreeMemo::add_summary(const HtmlNode* node, const Summary& summary) {
+    if (2 * (summary_count_ + 1) > slots_.size()) {
+        std::vector<Slot> old(std::max<std::size_t>(64, 2 * slots_.size()),
+                              Slot{nullptr, Summary()});
+        old.swap(slots_);
+        summary_count_ = 0;
+        for (const Slot& slot : old) {
+            if (slot.node) {
+                add_summary(slot.node, slot.summary);
+            }
+        }
+    }
+
+    std::size_t i = slot_of(node);
+    while (slots_[i].node) {
+        i = (i + 1) & (slots_.size() - 1);
+    }
+    slots_[i] = {node, summary};
+    ++summary_count_;
+}
+
+const SubtreeMemo::Summary* SubtreeMemo::find_summary(const HtmlNode* node) const {
+    if (slots_.empty()) {
+        return nullptr;
+    }
+    for (std::size_t i = slot_of(node); slots_[i].node; i = (i + 1) & (slots_.size() - 1)) {
+        if (slots_[i].node == node) {
+            return &slots_[i].summary;
+        }
+    }
+    return nullptr;
+}
+
+void SubtreeMemo::finish() {
+    std::swap(previous_, current_);
+    current_.clear();
+}
+
+void SubtreeMemo::clear() {
+    owner_ = nullptr;
+    previous_.clear();
+    current_.clear();
+    pending_.clear();
+    slots_.clear();
+    summary_count_ = 0;
+    reused_count_ = 0;
+    stored_count_ = 0;
+}
+
+SubtreeMemo::Lookup SubtreeMemo::lookup(const HtmlNode* element, const ParentContext& context,
+                                        std::size_t depth, MarkdownWriter& out) {
+    const Summary* found = find_summary(element);
+    if (!found) {
+        return Lookup::SKIP;
+    }
+    const Summary& summary = *found;
+    if (summary.feeds_table && context.table) {
+        return Lookup::SKIP;
+    }
+    int* counter = summary.counts_items ? context.list_counter : nullptr;
+
+    Hasher hasher;
+    hasher.add(summary.hash);
+    std::uint64_t word = 0;
+    for (std::size_t i = 0; i < kTagCount; ++i) {
+        word |= static_cast<std::uint64_t>(context.tags[i]) << (i % 64);
+        if (i % 64 == 63 || i + 1 == kTagCount) {
+            hasher.add(word);
+            word = 0;
+        }
+    }
+    hasher.add(static_cast<std::uint64_t>(context.inline_only) |
+               static_cast<std::uint64_t>(context.no_format) << 1 |
+               static_cast<std::uint64_t>(counter != nullptr) << 2);
+    hasher.add(static_cast<std::uint64_t>(context.list_depth));
+    if (counter) {
+        hasher.add(static_cast<std::uint64_t>(*counter));
+    }
+    if (depth_matters_) {
+        hasher.add(static_cast<std::uint64_t>(depth));
+    }
+    Hash128 key = hasher.finish();
+
+    std::size_t entry;
+    auto current = current_.index.find(key);
+    if (current != current_.index.end()) {
+        entry = current->second;
+    } else {
+        auto previous = previous_.index.find(key);
+        if (previous == previous_.index.end()) {
+            pending_.push_back({key, current_.entries.size(), counter, counter ? *counter : 0});
+            return Lookup::MISS;
+        }
+        entry = adopt(previous->second);
+    }
+
+    const Entry& reused = current_.entries[entry];
+    out.append(reused.markdown);
+    if (counter) {
+        *counter += reused.counter_delta;
+    }
+    ++reused_count_;
+    return Lookup::HIT;
+}
+
+// Moves a previous entry into the current generation along with the entries
+// of its descendants, which are not looked up on a hit but may be needed
+// when a later document changes something below it. Entries already taken
+// over are skipped, and descendant counts are adjusted to match.
+std::size_t SubtreeMemo::adopt(std::size_t entry) {
+    std::size_t first = entry - previous_.entries[entry].descendants;
+    std::size_t moved = 0;
+    moved_.clear();
+    for (std::size_t i = first; i <= entry; ++i) {
+        moved_.push_back(moved);
+        Entry& old = previous_.entries[i];
+        if (current_.index.count(old.key) > 0) {
+            continue;
+        }
+        std::size_t descendants = moved - moved_[i - old.descendants - first];
+        current_.index.emplace(old.key, current_.entries.size());
+        current_.entries.push_back(
+            {old.key, std::move(old.markdown), old.counter_delta, descendants});
+        ++moved;
+    }
+    return current_.entries.size() - 1;
+}
+
+void SubtreeMemo::store(std::string_view markdown) {
+    Pending pending = pending_.back();
+    pending_.pop_back();
+
+    int delta = pending.counter ? *pending.counter - pending.counter_before : 0;
+    std::size_t descendants = current_.entries.size() - pending.first_entry;
+    current_.index.emplace(pending.key, current_.entries.size());
+    current_.entries.push_back({pending.key, std::string(markdown), delta, descendants});
+    ++stored_count_;
+}
+
+}
+
+SubtreeCache::SubtreeCache()
+    : memo_(std::make_unique<detail::SubtreeMemo>()) {
+}
+
+SubtreeCache::~SubtreeCache() = default;
+
+std::size_t SubtreeCache::reused_count() const {
+    return memo_->reused_count();
+}
+
+std::size_t SubtreeCache::stored_count() const {
+    return memo_->stored_count();
+}
+
+std::size_t SubtreeCache::size() const {
+    return memo_->size();
+}
+
+void SubtreeCache::clear() {
+    memo_->clear();
+}
+
+}
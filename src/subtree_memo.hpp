@@ -0,0 +1,135 @@
+#pragma once
+
+#include "markdownify/converter.hpp"
+#include "hash.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace markdownify {
+namespace detail {
+
+// The Markdown of element subtrees, keyed by a hash of their markup and of
+// the parts of the context they are converted in. Entries found again in
+// the next document are reused, the others are dropped after it.
+//
+// An element's Markdown only depends on its subtree and its context, except
+// for two side effects, which are accounted for:
+// - list items take numbers from the counter of the enclosing ol. The
+//   counter's value goes into the key, and a reused subtree advances it by
+//   as many items as it numbered.
+// - rows and cells hand their text to the enclosing table's builder rather
+//   than writing it. Subtrees that contain them are never stored while a
+//   table is open.
+class SubtreeMemo {
+public:
+    enum class Lookup {
+        // The stored Markdown was appended.
+        HIT,
+        // Not stored: the caller converts the element and passes the result
+        // to store().
+        MISS,
+        // Not worth storing or not storable in this context.
+        SKIP
+    };
+
+    // Hashes the subtrees of doc. owner and version identify the converter
+    // and its custom handlers: entries of another converter or version are
+    // dropped, as its output may differ.
+    void begin(const void* owner, std::uint64_t version, const HtmlDocument& doc,
+               bool depth_matters);
+
+    // Keeps the entries of this document for the next one.
+    void finish();
+
+    void clear();
+
+    Lookup lookup(const HtmlNode* element, const ParentContext& context, std::size_t depth,
+                  MarkdownWriter& out);
+
+    // The Markdown of the element of the last MISS not stored yet.
+    void store(std::string_view markdown);
+
+    std::size_t size() const { return previous_.entries.size(); }
+    std::size_t reused_count() const { return reused_count_; }
+    std::size_t stored_count() const { return stored_count_; }
+
+private:
+    // Elements with fewer nodes in their subtree are converted every time:
+    // looking them up would cost about as much.
+    static constexpr std::size_t kMinNodes = 4;
+
+    struct Summary {
+        Hash128 hash;
+        // Has list items numbered by the counter of an enclosing ol.
+        bool counts_items;
+        // Has rows or cells that belong to an enclosing table.
+        bool feeds_table;
+    };
+
+    // Entries are kept in the order their elements closed, so the entries
+    // of an element's descendants come right before its own.
+    struct Entry {
+        Hash128 key;
+        std::string markdown;
+        int counter_delta;
+        std::size_t descendants;
+    };
+
+    struct Generation {
+        std::vector<Entry> entries;
+        std::unordered_map<Hash128, std::size_t, Hash128Hasher> index;
+
+        void clear() {
+            entries.clear();
+            index.clear();
+        }
+    };
+
+    struct Pending {
+        Hash128 key;
+        std::size_t first_entry;
+        int* counter;
+        int counter_before;
+    };
+
+    // A node whose children are being hashed.
+    struct Open {
+        const HtmlNode* node;
+        Hasher hasher;
+        std::size_t nodes;
+        bool counts_items;
+        bool feeds_table;
+    };
+
+    // Open addressing on the node address; rebuilt for every document.
+    struct Slot {
+        const HtmlNode* node;
+        Summary summary;
+    };
+
+    const void* owner_ = nullptr;
+    std::uint64_t version_ = 0;
+    bool depth_matters_ = false;
+    std::vector<Slot> slots_;
+    std::size_t summary_count_ = 0;
+    std::vector<Open> open_;
+    Generation previous_;
+    Generation current_;
+    std::vector<Pending> pending_;
+    std::vector<std::size_t> moved_;
+    std::size_t reused_count_ = 0;
+    std::size_t stored_count_ = 0;
+
+    void close_node();
+    void add_summary(const HtmlNode* node, const Summary& summary);
+    const Summary* find_summary(const HtmlNode* node) const;
+    std::size_t slot_of(const HtmlNode* node) const;
+    std::size_t adopt(std::size_t entry);
+};
+
+}
+}
@@ -0,0 +1,259 @@
+#include "table_builder.hpp"
+#include "markdownify/text_utils.hpp"
+#include <algorithm>
+
+namespace markdownify {
+namespace detail {
+
+namespace {
+
+constexpr std::size_t kMinDashes = 3;
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+}
+
+void TableBuilder::clear() {
+    text_.clear();
+    cells_.clear();
+    rows_.clear();
+    row_count_ = 0;
+    row_open_ = false;
+    free_from_.clear();
+    aligns_.clear();
+    next_column_ = 0;
+}
+
+void TableBuilder::grow(std::size_t columns) {
+    if (columns > aligns_.size()) {
+        free_from_.resize(columns, 0);
+        aligns_.resize(columns, ColumnAlign::NONE);
+    }
+}
+
+void TableBuilder::start_row(bool in_head) {
+    if (row_open_) {
+        end_row();
+    }
+    rows_.push_back({cells_.size(), text_.size(), in_head});
+    ++row_count_;
+    row_open_ = true;
+    row_all_th_ = true;
+    next_column_ = 0;
+}
+
+void TableBuilder::end_row() {
+    if (!row_open_) {
+        return;
+    }
+    row_open_ = false;
+
+    Row& row = rows_.back();
+    if (row.first_cell == cells_.size()) {
+        rows_.pop_back();
+        return;
+    }
+    row.header = row.header || row_all_th_;
+}
+
+// Cell text goes on one line: surrounding whitespace is trimmed, line breaks
+// become a single space and pipes are escaped.
+void TableBuilder::add_cell(std::string_view text, bool header, std::size_t colspan,
+                            std::size_t rowspan, ColumnAlign align) {
+    if (!row_open_) {
+        start_row(false);
+    }
+
+    std::size_t row = row_count_ - 1;
+    std::size_t column = next_column_;
+    while (column < free_from_.size() && free_from_[column] > row) {
+        ++column;
+    }
+    grow(column + colspan);
+    for (std::size_t c = column; c < column + colspan; ++c) {
+        free_from_[c] = row + rowspan;
+    }
+    next_column_ = column + colspan;
+
+    std::size_t begin = 0;
+    std::size_t end = text.size();
+    while (begin < end && is_space(text[begin])) ++begin;
+    while (end > begin && is_space(text[end - 1])) --end;
+
+    std::size_t offset = text_.size();
+    std::string_view cell = text.substr(begin, end - begin);
+    bool plain = true;
+    for (char c : cell) {
+        if (c == '\n' || c == '|') {
+            plain = false;
+            break;
+        }
+    }
+    if (plain) {
+        text_.append(cell.data(), cell.size());
+    } else {
+        append_escaped(cell);
+    }
+
+    cells_.push_back({static_cast<std::uint32_t>(column),
+                      static_cast<std::uint32_t>(text_.size() - offset)});
+    if (rows_.size() == 1 && align != ColumnAlign::NONE) {
+        aligns_[column] = align;
+    }
+    row_all_th_ = row_all_th_ && header;
+}
+
+void TableBuilder::append_escaped(std::string_view text) {
+    std::size_t backslashes = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (is_space(c)) {
+            std::size_t run = i;
+            bool newline = false;
+            while (run < text.size() && is_space(text[run])) {
+                newline = newline || text[run] == '\n';
+                ++run;
+            }
+            if (newline) {
+                text_ += ' ';
+                backslashes = 0;
+                i = run - 1;
+                continue;
+            }
+        }
+        if (c == '|' && backslashes % 2 == 0) {
+            text_ += '\\';
+        }
+        backslashes = c == '\\' ? backslashes + 1 : 0;
+        text_ += c;
+    }
+}
+
+// Terminal columns, so that wide and combining characters line up.
+std::size_t TableBuilder::width(std::size_t offset, std::size_t length) const {
+    return display_width(std::string_view(text_).substr(offset, length));
+}
+
+void TableBuilder::render(std::string& out, bool infer_header, bool pad) {
+    if (rows_.empty()) {
+        return;
+    }
+
+    widths_.assign(columns(), kMinDashes);
+    if (pad) {
+        std::size_t offset = 0;
+        for (const Cell& cell : cells_) {
+            widths_[cell.column] = std::max(widths_[cell.column], width(offset, cell.length));
+            offset += cell.length;
+        }
+    }
+
+    std::size_t line = 2;
+    for (std::size_t w : widths_) {
+        line += w + 3;
+    }
+    out.reserve(out.size() + text_.size() + (rows_.size() + 2) * line);
+
+    std::size_t first = 0;
+    if (rows_[0].header || infer_header) {
+        render_row(out, 0, pad);
+        first = 1;
+    } else {
+        render_empty_row(out, pad);
+    }
+    render_separator(out);
+
+    for (std::size_t r = first; r < rows_.size(); ++r) {
+        render_row(out, r, pad);
+    }
+}
+
+void TableBuilder::render_text(std::string& out) const {
+    std::size_t offset = 0;
+    for (const Cell& cell : cells_) {
+        if (cell.length > 0) {
+            if (!out.empty() && !is_space(out.back())) {
+                out += ' ';
+            }
+            out.append(text_, offset, cell.length);
+        }
+        offset += cell.length;
+    }
+}
+
+// Slots without a cell, covered by a span or past the end of a short row,
+// are written empty.
+void TableBuilder::render_row(std::string& out, std::size_t row, bool pad) const {
+    const Cell* cell = cells_.data() + rows_[row].first_cell;
+    const Cell* end = cells_.data() +
+                      (row + 1 < rows_.size() ? rows_[row + 1].first_cell : cells_.size());
+    std::size_t offset = rows_[row].offset;
+
+    out += "| ";
+    for (std::size_t c = 0; c < columns(); ++c) {
+        bool filled = cell != end && cell->column == c;
+        std::size_t length = filled ? cell->length : 0;
+        std::size_t fill = pad ? widths_[c] - width(offset, length) : 0;
+        std::size_t before = 0;
+        if (aligns_[c] == ColumnAlign::RIGHT) {
+            before = fill;
+        } else if (aligns_[c] == ColumnAlign::CENTER) {
+            before = fill / 2;
+        }
+
+        if (before > 0) {
+            out.append(before, ' ');
+        }
+        if (filled) {
+            out.append(text_, offset, length);
+            offset += length;
+            ++cell;
+        }
+        if (fill > before) {
+            out.append(fill - before, ' ');
+        }
+        out += c + 1 < columns() ? " | " : " |\n";
+    }
+}
+
+void TableBuilder::render_empty_row(std::string& out, bool pad) const {
+    out += '|';
+    for (std::size_t c = 0; c < columns(); ++c) {
+        out.append(pad ? widths_[c] + 2 : 2, ' ');
+        out += '|';
+    }
+    out += '\n';
+}
+
+void TableBuilder::render_separator(std::string& out) const {
+    out += '|';
+    for (std::size_t c = 0; c < columns(); ++c) {
+        std::size_t dashes = widths_[c];
+        out += ' ';
+        switch (aligns_[c]) {
+            case ColumnAlign::LEFT:
+                out += ':';
+                out.append(dashes - 1, '-');
+                break;
+            case ColumnAlign::CENTER:
+                out += ':';
+                out.append(dashes - 2, '-');
+                out += ':';
+                break;
+            case ColumnAlign::RIGHT:
+                out.append(dashes - 1, '-');
+                out += ':';
+                break;
+            default:
+                out.append(dashes, '-');
+                break;
+        }
+        out += " |";
+    }
+    out += '\n';
+}
+
+}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace markdownify {
+namespace detail {
+
+enum class ColumnAlign {
+    NONE,
+    LEFT,
+    CENTER,
+    RIGHT
+};
+
+// Cells of one table, collected during the walk and rendered as a GFM table
+// at its end. Cells are placed on a grid as they arrive: a colspan or
+// rowspan reserves the slots it covers, which render as empty cells.
+class TableBuilder {
+public:
+    void clear();
+
+    bool empty() const { return rows_.empty(); }
+
+    // Rows inside thead are header rows; so are rows made only of th cells.
+    void start_row(bool in_head);
+    void end_row();
+
+    // Adds the converted text of a cell. Starts a row if none is open.
+    void add_cell(std::string_view text, bool header, std::size_t colspan,
+                  std::size_t rowspan, ColumnAlign align);
+
+    // Appends the table to out. The first row is the header when it is a
+    // header row or infer_header is set; otherwise an empty header row is
+    // written. With pad, every column is as wide as its widest cell.
+    void render(std::string& out, bool infer_header, bool pad);
+
+    // Appends only the cell texts, separated by spaces, for a table where a
+    // GFM table cannot go, such as inside another table's cell.
+    void render_text(std::string& out) const;
+
+private:
+    // Cell texts are stored one after another in text_, so a cell's offset
+    // is the sum of the lengths before it.
+    struct Cell {
+        std::uint32_t column;
+        std::uint32_t length;
+    };
+
+    struct Row {
+        std::size_t first_cell;
+        std::size_t offset;
+        bool header;
+    };
+
+    std::string text_;
+    std::vector<Cell> cells_;
+    std::vector<Row> rows_;
+    // Rows started so far, empty ones included: spans count them even
+    // though they are not rendered.
+    std::size_t row_count_ = 0;
+    bool row_open_ = false;
+    bool row_all_th_ = true;
+
+    // Per column: the first row whose slot is not taken by a cell placed
+    // so far, and the alignment of the first row.
+    std::vector<std::size_t> free_from_;
+    std::vector<ColumnAlign> aligns_;
+    std::size_t next_column_ = 0;
+
+    // Rendered column widths. Only measured when padding.
+    std::vector<std::size_t> widths_;
+
+    std::size_t columns() const { return aligns_.size(); }
+    std::size_t width(std::size_t offset, std::size_t length) const;
+    void grow(std::size_t columns);
+    void append_escaped(std::string_view text);
+    void render_row(std::string& out, std::size_t row, bool pad) const;
+    void render_empty_row(std::string& out, bool pad) const;
+    void render_separator(std::string& out) const;
+};
+
+}
+}
@@ -1,6 +1,9 @@
 #include "markdownify/text_utils.hpp"
+#include "simd_scan.hpp"
 #include <algorithm>
-#include <sstream>
+#include <array>
+#include <cstring>
+#include <iterator>
 
 namespace markdownify {
 
@@ -21,47 +24,162 @@ ChompResult chomp(const std::string& text) {
     return result;
 }
 
+// Equivalent to removing ^[ \n]*\n and then [ \n]*$.
+std::string_view strip_pre_view(std::string_view text) {
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < text.size() && (text[i] == ' ' || text[i] == '\n'); ++i) {
+        if (text[i] == '\n') {
+            begin = i + 1;
+        }
+    }
+
+    std::size_t end = text.size();
+    while (end > begin && (text[end - 1] == ' ' || text[end - 1] == '\n')) {
+        --end;
+    }
+
+    return text.substr(begin, end - begin);
+}
+
+// Equivalent to removing ^ *\n and then \n *$.
+std::string_view strip1_pre_view(std::string_view text) {
+    std::size_t begin = 0;
+    while (begin < text.size() && text[begin] == ' ') {
+        ++begin;
+    }
+    begin = (begin < text.size() && text[begin] == '\n') ? begin + 1 : 0;
+
+    std::size_t end = text.size();
+    while (end > begin && text[end - 1] == ' ') {
+        --end;
+    }
+    end = (end > begin && text[end - 1] == '\n') ? end - 1 : text.size();
+
+    return text.substr(begin, end - begin);
+}
+
+void strip_pre(std::string_view text, std::string& out) {
+    std::string_view kept = strip_pre_view(text);
+    out.append(kept.data(), kept.size());
+}
+
+void strip1_pre(std::string_view text, std::string& out) {
+    std::string_view kept = strip1_pre_view(text);
+    out.append(kept.data(), kept.size());
+}
+
 std::string strip_pre(const std::string& text) {
-    return std::regex_replace(
-        std::regex_replace(text, RegexPatterns::pre_lstrip(), ""),
-        RegexPatterns::pre_rstrip(), ""
-    );
+    std::string result;
+    strip_pre(text, result);
+    return result;
 }
 
 std::string strip1_pre(const std::string& text) {
-    return std::regex_replace(
-        std::regex_replace(text, RegexPatterns::pre_lstrip1(), ""),
-        RegexPatterns::pre_rstrip1(), ""
-    );
+    std::string result;
+    strip1_pre(text, result);
+    return result;
 }
 
-std::string escape_markdown(const std::string& text, bool escape_asterisks,
-                           bool escape_underscores, bool escape_misc) {
-    std::string result = text;
+namespace {
 
-    if (escape_misc) {
-        result = std::regex_replace(result, RegexPatterns::escape_misc_chars(), "\\$1");
-        result = std::regex_replace(result, RegexPatterns::escape_misc_dash_sequences(), "$1\\$2");
-        result = std::regex_replace(result, RegexPatterns::escape_misc_hashes(), "$1\\$2");
-        result = std::regex_replace(result, RegexPatterns::escape_misc_list_items(), "$1\\$2");
-    }
+// The characters matched by \s in std::regex.
+bool is_regex_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
 
-    if (escape_asterisks) {
-        size_t pos = 0;
-        while ((pos = result.find('*', pos)) != std::string::npos) {
-            result.replace(pos, 1, "\\*");
-            pos += 2;
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+const detail::ByteSet& escape_set(bool escape_asterisks, bool escape_underscores,
+                                  bool escape_misc) {
+    static const auto sets = [] {
+        std::array<detail::ByteSet, 8> result;
+        for (int flags = 0; flags < 8; ++flags) {
+            if (flags & 1) result[flags].add('*');
+            if (flags & 2) result[flags].add('_');
+            if (flags & 4) {
+                for (char c : std::string_view("-#0123456789")) {
+                    result[flags].add(static_cast<unsigned char>(c));
+                }
+            }
+        }
+        return result;
+    }();
+    return sets[(escape_asterisks ? 1 : 0) | (escape_underscores ? 2 : 0) | (escape_misc ? 4 : 0)];
+}
+
+}
+
+// One pass over the text, equivalent to the escape_misc regex passes
+// (dash runs, 1-6 hashes and 1-9 digit list markers, each preceded by \s or
+// the start and followed by \s or the end) followed by replacing every * and
+// _. Each rule consumes its trailing whitespace, which therefore cannot start
+// the next match of the same rule, as with std::regex_replace.
+void escape_markdown(std::string_view text, bool escape_asterisks,
+                     bool escape_underscores, bool escape_misc, std::string& out) {
+    const detail::ByteSet& special = escape_set(escape_asterisks, escape_underscores, escape_misc);
+    const char* data = text.data();
+    const std::size_t size = text.size();
+
+    std::size_t dash_end = 0;
+    std::size_t hash_end = 0;
+    std::size_t list_end = 0;
+    auto starts_match = [&](std::size_t pos, std::size_t rule_end) {
+        return pos == 0 || (pos > rule_end && is_regex_space(data[pos - 1]));
+    };
+    auto ends_match = [&](std::size_t pos) {
+        return pos == size || is_regex_space(data[pos]);
+    };
+
+    out.reserve(out.size() + size);
+    std::size_t pos = 0;
+    while (pos < size) {
+        std::size_t hit = pos + detail::find_first_in_set(data + pos, size - pos, special);
+        out.append(data + pos, hit - pos);
+        if (hit == size) {
+            break;
+        }
+
+        char c = data[hit];
+        if (c == '*' || c == '_') {
+            out += '\\';
+            out += c;
+            pos = hit + 1;
+            continue;
         }
-    }
 
-    if (escape_underscores) {
-        size_t pos = 0;
-        while ((pos = result.find('_', pos)) != std::string::npos) {
-            result.replace(pos, 1, "\\_");
-            pos += 2;
+        std::size_t run_end = hit + 1;
+        if (is_digit(c)) {
+            while (run_end < size && is_digit(data[run_end])) ++run_end;
+            std::size_t length = run_end - hit;
+            if (length <= 9 && run_end < size && (data[run_end] == '.' || data[run_end] == ')') &&
+                ends_match(run_end + 1) && starts_match(hit, list_end)) {
+                out.append(data + hit, length);
+                out += '\\';
+                out += data[run_end];
+                list_end = std::min(run_end + 2, size);
+                pos = run_end + 1;
+                continue;
+            }
+        } else {
+            while (run_end < size && data[run_end] == c) ++run_end;
+            std::size_t& rule_end = c == '-' ? dash_end : hash_end;
+            if ((c == '-' || run_end - hit <= 6) && ends_match(run_end) &&
+                starts_match(hit, rule_end)) {
+                out += '\\';
+                rule_end = std::min(run_end + 1, size);
+            }
         }
+        out.append(data + hit, run_end - hit);
+        pos = run_end;
     }
+}
 
+std::string escape_markdown(const std::string& text, bool escape_asterisks,
+                           bool escape_underscores, bool escape_misc) {
+    std::string result;
+    escape_markdown(text, escape_asterisks, escape_underscores, escape_misc, result);
     return result;
 }
 
@@ -99,102 +217,295 @@ std::string trim_right(const std::string& str) {
     return std::string(str.begin(), it.base());
 }
 
-std::string wrap_text(const std::string& text, int width) {
-    if (width <= 0) {
-        return text;
+namespace {
+
+struct CodePointRange {
+    char32_t first;
+    char32_t last;
+};
+
+// Combining marks and zero-width characters.
+constexpr CodePointRange kZeroWidth[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF},
+    {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A},
+    {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4},
+    {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x1AB0, 0x1AFF},
+    {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x2028, 0x202E}, {0x2060, 0x2064},
+    {0x20D0, 0x20FF}, {0x302A, 0x302D}, {0x3099, 0x309A}, {0xFE00, 0xFE0F},
+    {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF}, {0xE0100, 0xE01EF},
+};
+
+// East Asian wide and fullwidth characters, and emoji.
+constexpr CodePointRange kWide[] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC},
+    {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615},
+    {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1},
+    {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, {0x26CE, 0x26CE},
+    {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B},
+    {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+    {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF},
+    {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0x3029},
+    {0x302E, 0x303E}, {0x3041, 0x3098}, {0x309B, 0x33FF}, {0x3400, 0x4DBF},
+    {0x4E00, 0xA4CF}, {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF},
+    {0xFE10, 0xFE19}, {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6},
+    {0x16FE0, 0x16FE4}, {0x17000, 0x18CFF}, {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004},
+    {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F202},
+    {0x1F210, 0x1F23B}, {0x1F240, 0x1F248}, {0x1F250, 0x1F251}, {0x1F260, 0x1F265},
+    {0x1F300, 0x1F320}, {0x1F32D, 0x1F335}, {0x1F337, 0x1F37C}, {0x1F37E, 0x1F393},
+    {0x1F3A0, 0x1F3CA}, {0x1F3CF, 0x1F3D3}, {0x1F3E0, 0x1F3F0}, {0x1F3F4, 0x1F3F4},
+    {0x1F3F8, 0x1F43E}, {0x1F440, 0x1F440}, {0x1F442, 0x1F4FC}, {0x1F4FF, 0x1F53D},
+    {0x1F54B, 0x1F54E}, {0x1F550, 0x1F567}, {0x1F57A, 0x1F57A}, {0x1F595, 0x1F596},
+    {0x1F5A4, 0x1F5A4}, {0x1F5FB, 0x1F64F}, {0x1F680, 0x1F6C5}, {0x1F6CC, 0x1F6CC},
+    {0x1F6D0, 0x1F6D2}, {0x1F6D5, 0x1F6D7}, {0x1F6EB, 0x1F6EC}, {0x1F6F4, 0x1F6FC},
+    {0x1F7E0, 0x1F7EB}, {0x1F90C, 0x1F93A}, {0x1F93C, 0x1F945}, {0x1F947, 0x1F9FF},
+    {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+};
+
+template <std::size_t N>
+bool in_ranges(const CodePointRange (&ranges)[N], char32_t c) {
+    auto after = std::upper_bound(std::begin(ranges), std::end(ranges), c,
+                                  [](char32_t c, const CodePointRange& r) { return c < r.first; });
+    return after != std::begin(ranges) && c <= (after - 1)->last;
+}
+
+std::size_t code_point_width(char32_t c) {
+    if (c < 0x0300) {
+        return 1;
     }
+    if (in_ranges(kZeroWidth, c)) {
+        return 0;
+    }
+    return c >= 0x1100 && in_ranges(kWide, c) ? 2 : 1;
+}
 
-    std::istringstream words(text);
-    std::ostringstream wrapped;
-    std::string word;
+// Decodes the code point starting at text[i] and moves i past it. Bytes
+// that do not start a valid sequence decode to themselves, one at a time.
+char32_t decode_utf8(std::string_view text, std::size_t& i) {
+    auto lead = static_cast<unsigned char>(text[i]);
+    std::size_t length = lead < 0xC2 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : lead < 0xF5 ? 4 : 1;
+    if (length == 1 || i + length > text.size()) {
+        ++i;
+        return lead;
+    }
 
-    int line_length = 0;
-    while (words >> word) {
-        if (line_length + word.length() + 1 > static_cast<size_t>(width)) {
-            if (line_length > 0) {
-                wrapped << "\n";
-            }
-            wrapped << word;
-            line_length = word.length();
-        } else {
-            if (line_length > 0) {
-                wrapped << " ";
-                line_length++;
-            }
-            wrapped << word;
-            line_length += word.length();
+    char32_t c = lead & (0x7F >> length);
+    for (std::size_t k = 1; k < length; ++k) {
+        auto byte = static_cast<unsigned char>(text[i + k]);
+        if ((byte & 0xC0) != 0x80) {
+            ++i;
+            return lead;
         }
+        c = (c << 6) | (byte & 0x3F);
     }
-
-    return wrapped.str();
+    i += length;
+    return c;
 }
 
-std::string collapse_whitespace(const std::string& text) {
-    return std::regex_replace(text, RegexPatterns::whitespace(), " ");
+bool is_wrap_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
 }
 
-std::string normalize_newlines(const std::string& text) {
-    return std::regex_replace(text, RegexPatterns::newline_whitespace(), "\n");
+// Whether the newline at text[i] ends a line in Markdown: it follows two
+// spaces or an unescaped backslash. Others are soft breaks, read as spaces.
+bool is_hard_break(std::string_view text, std::size_t i) {
+    if (i >= 2 && text[i - 1] == ' ' && text[i - 2] == ' ') {
+        return true;
+    }
+    std::size_t backslashes = 0;
+    while (backslashes < i && text[i - 1 - backslashes] == '\\') {
+        ++backslashes;
+    }
+    return backslashes % 2 == 1;
 }
 
-const std::regex& RegexPatterns::whitespace() {
-    static std::regex pattern(R"([\t ]+)");
-    return pattern;
+// Index just past the bracket closing the one at line[i], skipping escaped
+// characters and nested pairs, or npos.
+std::size_t skip_brackets(std::string_view line, std::size_t i, char open, char close) {
+    int depth = 0;
+    for (; i < line.size(); ++i) {
+        if (line[i] == '\\') {
+            ++i;
+        } else if (line[i] == open) {
+            ++depth;
+        } else if (line[i] == close && --depth == 0) {
+            return i + 1;
+        }
+    }
+    return std::string_view::npos;
 }
 
-const std::regex& RegexPatterns::all_whitespace() {
-    static std::regex pattern(R"([\t \r\n]+)");
-    return pattern;
+// End of the word starting at line[i]: the next space that is not inside a
+// code span or an inline link or image, where the wrap must not break.
+std::size_t word_end(std::string_view line, std::size_t i) {
+    while (i < line.size() && !is_wrap_space(line[i])) {
+        if (line[i] == '\\') {
+            i += i + 1 < line.size() && !is_wrap_space(line[i + 1]) ? 2 : 1;
+        } else if (line[i] == '`') {
+            std::size_t run = line.find_first_not_of('`', i);
+            run = run == std::string_view::npos ? line.size() : run;
+            // A code span closes with a run of as many backticks.
+            std::size_t close = run;
+            while ((close = line.find('`', close)) != std::string_view::npos) {
+                std::size_t close_end = line.find_first_not_of('`', close);
+                close_end = close_end == std::string_view::npos ? line.size() : close_end;
+                if (close_end - close == run - i) {
+                    break;
+                }
+                close = close_end;
+            }
+            i = close == std::string_view::npos ? run : close + (run - i);
+        } else if (line[i] == '[') {
+            std::size_t text_end = skip_brackets(line, i, '[', ']');
+            std::size_t link_end = std::string_view::npos;
+            if (text_end < line.size() && line[text_end] == '(') {
+                link_end = skip_brackets(line, text_end, '(', ')');
+            }
+            i = link_end == std::string_view::npos ? i + 1 : link_end;
+        } else {
+            ++i;
+        }
+    }
+    return std::min(i, line.size());
 }
 
-const std::regex& RegexPatterns::newline_whitespace() {
-    static std::regex pattern(R"([\t \r\n]*[\r\n][\t \r\n]*)");
-    return pattern;
-}
+// Wraps text into out, which may be text itself: spaces between words are
+// replaced by a single space or newline, so nothing is written past the
+// byte being read. Returns the size of the wrapped text.
+std::size_t wrap_into(std::string_view text, std::size_t width, char* out) {
+    std::size_t written = 0;
+    std::size_t column = 0;
+    // Code spans and links are only matched within a line.
+    std::size_t line_end = 0;
+    std::size_t i = 0;
+    while (true) {
+        std::size_t space = i;
+        while (i < text.size() && is_wrap_space(text[i]) &&
+               !(text[i] == '\n' && is_hard_break(text, i))) {
+            ++i;
+        }
+        if (i == text.size()) {
+            return written;
+        }
+        if (text[i] == '\n') {
+            // Kept as it is, with the spaces that make it a hard break.
+            std::memmove(out + written, text.data() + space, i + 1 - space);
+            written += i + 1 - space;
+            column = 0;
+            ++i;
+            continue;
+        }
 
-const std::regex& RegexPatterns::pre_lstrip1() {
-    static std::regex pattern(R"(^ *\n)");
-    return pattern;
+        if (line_end <= i) {
+            line_end = std::min(text.find('\n', i), text.size());
+        }
+        std::size_t end = word_end(text.substr(0, line_end), i);
+        std::size_t word_width = display_width(text.substr(i, end - i));
+        if (column > 0) {
+            if (column + 1 + word_width > width) {
+                out[written++] = '\n';
+                column = 0;
+            } else {
+                out[written++] = ' ';
+                ++column;
+            }
+        }
+        std::memmove(out + written, text.data() + i, end - i);
+        written += end - i;
+        column += word_width;
+        i = end;
+    }
 }
 
-const std::regex& RegexPatterns::pre_rstrip1() {
-    static std::regex pattern(R"(\n *$)");
-    return pattern;
 }
 
-const std::regex& RegexPatterns::pre_lstrip() {
-    static std::regex pattern(R"(^[ \n]*\n)");
-    return pattern;
+std::size_t display_width(std::string_view text) {
+    std::size_t width = 0;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        if (static_cast<unsigned char>(text[i]) < 0x80) {
+            ++width;
+            ++i;
+        } else {
+            width += code_point_width(decode_utf8(text, i));
+        }
+    }
+    return width;
 }
 
-const std::regex& RegexPatterns::pre_rstrip() {
-    static std::regex pattern(R"([ \n]*$)");
-    return pattern;
+void wrap_text(std::string_view text, int width, std::string& out) {
+    if (width <= 0) {
+        out.append(text.data(), text.size());
+        return;
+    }
+    std::size_t start = out.size();
+    out.resize(start + text.size());
+    out.resize(start + wrap_into(text, static_cast<std::size_t>(width), &out[start]));
 }
 
-const std::regex& RegexPatterns::escape_misc_chars() {
-    static std::regex pattern(R"([]\&<`[>~=+|])");
-    return pattern;
+void wrap_text_in_place(std::string& text, std::size_t pos, int width) {
+    if (width <= 0 || pos >= text.size()) {
+        return;
+    }
+    std::string_view tail = std::string_view(text).substr(pos);
+    text.resize(pos + wrap_into(tail, static_cast<std::size_t>(width), &text[pos]));
 }
 
-const std::regex& RegexPatterns::escape_misc_dash_sequences() {
-    static std::regex pattern(R"((\s|^)(-+(?:\s|$)))");
-    return pattern;
+std::string wrap_text(const std::string& text, int width) {
+    std::string wrapped;
+    wrap_text(std::string_view(text), width, wrapped);
+    return wrapped;
 }
 
-const std::regex& RegexPatterns::escape_misc_hashes() {
-    static std::regex pattern(R"((\s|^)(#{1,6}(?:\s|$)))");
-    return pattern;
+// Replaces every run of spaces and tabs with a single space.
+void collapse_whitespace(std::string_view text, std::string& out) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+    out.reserve(out.size() + text.size());
+    while (p < end) {
+        const char* run = p;
+        while (p < end && *p != ' ' && *p != '\t') ++p;
+        out.append(run, p - run);
+        if (p == end) {
+            break;
+        }
+
+        out += ' ';
+        ++p;
+        while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    }
 }
 
-const std::regex& RegexPatterns::escape_misc_list_items() {
-    static std::regex pattern(R"(((?:\s|^)[0-9]{1,9})([.)](?:\s|$)))");
-    return pattern;
+std::string collapse_whitespace(const std::string& text) {
+    std::string result;
+    collapse_whitespace(text, result);
+    return result;
 }
 
-const std::regex& RegexPatterns::backtick_runs() {
-    static std::regex pattern(R"(`+)");
-    return pattern;
+std::string normalize_newlines(const std::string& text) {
+    auto is_blank = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+
+    std::string result;
+    result.reserve(text.size());
+    std::size_t i = 0;
+    while (i < text.size()) {
+        if (!is_blank(text[i])) {
+            result += text[i++];
+            continue;
+        }
+        std::size_t run = i;
+        bool line_break = false;
+        for (; i < text.size() && is_blank(text[i]); ++i) {
+            line_break = line_break || text[i] == '\r' || text[i] == '\n';
+        }
+        if (line_break) {
+            result += '\n';
+        } else {
+            result.append(text, run, i - run);
+        }
+    }
+    return result;
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "worker_pool.hpp"
+#include <chrono>
+
+namespace markdownify {
+namespace detail {
+
+namespace {
+
+// Waits until ready() holds. Timed waits on the steady clock are inlined by
+// libstdc++, while condition_variable::wait built with GCC 12 or later
+// needs a GLIBCXX_3.4.30 runtime; the deadline is far enough away never to
+// matter.
+template <typename Predicate>
+void wait_until_ready(std::condition_variable& cv, std::unique_lock<std::mutex>& lock,
+                      Predicate ready) {
+    while (!cv.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::hours(24),
+                          ready)) {
+    }
+}
+
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+WorkerPool& WorkerPool::shared() {
+    static WorkerPool pool;
+    return pool;
+}
+
+void WorkerPool::run(unsigned workers, const std::function<void(unsigned)>& task) {
+    if (workers <= 1) {
+        task(0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> exclusive(run_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (threads_.size() < workers - 1) {
+            threads_.emplace_back([this] { work(); });
+        }
+        task_ = &task;
+        helpers_ = workers - 1;
+        next_slot_ = 1;
+        active_ = helpers_;
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    // The helpers still reference task, so they are waited for either way.
+    std::exception_ptr error;
+    try {
+        task(0);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    wait_until_ready(done_, lock, [this] { return active_ == 0; });
+    task_ = nullptr;
+    if (!error) {
+        error = helper_error_;
+    }
+    helper_error_ = nullptr;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Each thread takes at most one slot per run; threads beyond the number of
+// helpers asked for stay asleep.
+void WorkerPool::work() {
+    std::uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wait_until_ready(wake_, lock, [&] {
+            return stopping_ || (generation_ != seen && next_slot_ <= helpers_);
+        });
+        if (stopping_) {
+            return;
+        }
+
+        seen = generation_;
+        unsigned slot = next_slot_++;
+        const std::function<void(unsigned)>* task = task_;
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            (*task)(slot);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        if (error && !helper_error_) {
+            helper_error_ = error;
+        }
+
+        if (--active_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
+
+}
+}
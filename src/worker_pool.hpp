@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace markdownify {
+namespace detail {
+
+// Threads that outlive a single batch. run() hands the same task to a
+// number of workers, the calling thread being worker 0, and returns once
+// all of them have returned. If any worker throws, run() rethrows the
+// exception (worker 0's first) after all of them are done. Concurrent run()
+// calls take turns.
+class WorkerPool {
+public:
+    WorkerPool() = default;
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // The process-wide pool used by convert_batch.
+    static WorkerPool& shared();
+
+    void run(unsigned workers, const std::function<void(unsigned)>& task);
+
+private:
+    std::mutex run_mutex_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::vector<std::thread> threads_;
+    const std::function<void(unsigned)>* task_ = nullptr;
+    std::exception_ptr helper_error_;
+    std::uint64_t generation_ = 0;
+    unsigned helpers_ = 0;
+    unsigned next_slot_ = 0;
+    unsigned active_ = 0;
+    bool stopping_ = false;
+
+    void work();
+};
+
+}
+}
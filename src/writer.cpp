@@ -0,0 +1,52 @@
+#include "markdownify/writer.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace markdownify {
+
+void MarkdownWriter::replace(std::size_t pos, std::size_t count, std::string_view text) {
+    if (count == text.size()) {
+        std::memcpy(&buffer_[pos], text.data(), text.size());
+        return;
+    }
+    buffer_.replace(pos, count, text.data(), text.size());
+}
+
+// Same lines as std::getline over the text: a final newline does not start
+// an empty line, and an unterminated last line gets one. The buffer grows
+// once and lines are moved into place from the back.
+void MarkdownWriter::prefix_lines(std::size_t pos, std::string_view first, std::string_view rest) {
+    const std::size_t end = buffer_.size();
+    if (pos >= end) {
+        return;
+    }
+
+    const bool terminated = buffer_.back() == '\n';
+    std::size_t lines = std::count(buffer_.begin() + pos, buffer_.end(), '\n');
+    if (!terminated) {
+        ++lines;
+    }
+    std::size_t grown = first.size() + (lines - 1) * rest.size() + (terminated ? 0 : 1);
+    buffer_.resize(end + grown);
+
+    char* data = &buffer_[0];
+    std::size_t src = end;
+    std::size_t dst = end + grown;
+    for (std::size_t i = lines; i-- > 0;) {
+        std::size_t line_end = (i + 1 < lines || terminated) ? src - 1 : src;
+        std::size_t newline = std::string_view(data + pos, line_end - pos).rfind('\n');
+        std::size_t line_begin = newline == std::string_view::npos ? pos : pos + newline + 1;
+
+        std::size_t length = line_end - line_begin;
+        data[--dst] = '\n';
+        dst -= length;
+        std::memmove(data + dst, data + line_begin, length);
+
+        std::string_view prefix = i == 0 ? first : rest;
+        dst -= prefix.size();
+        std::memcpy(data + dst, prefix.data(), prefix.size());
+        src = line_begin;
+    }
+}
+
+}
@@ -1,5 +1,6 @@
 #include <markdownify/markdownify.hpp>
 #include <gtest/gtest.h>
+#include <cstdio>
 
 TEST(BasicTest, SimpleText) {
     std::string html = "Hello World";
@@ -119,4 +120,27 @@ TEST(BasicTest, LineBreak) {
     std::string result = markdownify::markdownify(html);
     EXPECT_TRUE(result.find("Line 1  \nLine 2") != std::string::npos ||
                 result.find("Line 1\\\nLine 2") != std::string::npos);
-}
\ No newline at end of file
+}
+TEST(BasicTest, ConvertFile) {
+    std::string path = ::testing::TempDir() + "markdownify_convert_file.html";
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        ASSERT_NE(file, nullptr);
+        std::fputs("<p>Some <b>text</b> &amp; <a href=\"/x\">more</a></p>", file);
+        std::fclose(file);
+    }
+
+    markdownify::MarkdownConverter converter;
+    auto result = converter.convert_file(path);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, "Some **text** & [more](/x)");
+
+    markdownify::ConversionSession session;
+    auto view = session.convert_file(path);
+    ASSERT_TRUE(view.has_value());
+    EXPECT_EQ(*view, *result);
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(converter.convert_file(path).has_value());
+    EXPECT_FALSE(session.convert_file(path).has_value());
+}
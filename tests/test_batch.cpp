@@ -0,0 +1,62 @@
+#include <markdownify/markdownify.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+namespace {
+
+std::vector<std::string> make_documents(int count) {
+    std::vector<std::string> docs;
+    for (int i = 0; i < count; ++i) {
+        std::string html = "<h2>Page " + std::to_string(i) + "</h2><ul>";
+        for (int j = 0; j < i % 7; ++j) {
+            html += "<li><b>item</b> " + std::to_string(j) + "</li>";
+        }
+        html += "</ul><p>snake_case *text*</p>";
+        docs.push_back(html);
+    }
+    return docs;
+}
+
+}
+
+TEST(BatchTest, ResultsMatchSingleConversionInOrder) {
+    std::vector<std::string> docs = make_documents(500);
+    std::vector<std::string_view> inputs(docs.begin(), docs.end());
+
+    for (unsigned threads : {0u, 1u, 2u, 3u, 8u, 100000u}) {
+        auto results = markdownify::convert_batch(inputs, markdownify::Options(), threads);
+        ASSERT_EQ(results.size(), docs.size());
+        for (std::size_t i = 0; i < docs.size(); ++i) {
+            EXPECT_TRUE(results[i].ok);
+            EXPECT_EQ(results[i].markdown, markdownify::markdownify(docs[i])) << i;
+        }
+    }
+}
+
+TEST(BatchTest, EmptyBatch) {
+    EXPECT_TRUE(markdownify::convert_batch(std::vector<std::string_view>()).empty());
+}
+
+TEST(BatchTest, FailuresAreReportedPerItem) {
+    markdownify::Options options;
+    options.code_language_callback = [](const std::string& cls) -> std::string {
+        if (cls == "bad") {
+            throw std::runtime_error("unsupported language");
+        }
+        return cls;
+    };
+
+    std::vector<std::string_view> inputs = {
+        "<pre class=\"cpp\">int x;</pre>",
+        "<pre class=\"bad\">x</pre>",
+        "<p>fine</p>",
+    };
+    std::vector<markdownify::BatchResult> results = markdownify::convert_batch(inputs, options, 2);
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_TRUE(results[0].ok);
+    EXPECT_EQ(results[0].markdown, "```cpp\nint x;\n```");
+    EXPECT_FALSE(results[1].ok);
+    EXPECT_EQ(results[1].error, "unsupported language");
+    EXPECT_TRUE(results[2].ok);
+    EXPECT_EQ(results[2].markdown, "fine");
+}
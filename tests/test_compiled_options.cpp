@@ -0,0 +1,94 @@
+#include <markdownify/markdownify.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+
+using markdownify::CompiledOptions;
+using markdownify::TagId;
+
+TEST(CompiledOptionsTest, StripTags) {
+    markdownify::Options options;
+    options.strip_tags = {"B", "custom-tag"};
+    CompiledOptions compiled(options);
+
+    EXPECT_FALSE(compiled.converts(TagId::B));
+    EXPECT_TRUE(compiled.converts(TagId::I));
+    EXPECT_FALSE(compiled.converts("custom-tag"));
+    EXPECT_TRUE(compiled.converts("other-tag"));
+    EXPECT_EQ(compiled.options().strip_tags.count("b"), 1u);
+}
+
+TEST(CompiledOptionsTest, ConvertTags) {
+    markdownify::Options options;
+    options.convert_tags = {"a", "custom-tag"};
+    CompiledOptions compiled(options);
+
+    EXPECT_TRUE(compiled.converts(TagId::A));
+    EXPECT_FALSE(compiled.converts(TagId::B));
+    // Containers are always converted.
+    EXPECT_TRUE(compiled.converts(TagId::DIV));
+    EXPECT_TRUE(compiled.converts("custom-tag"));
+    EXPECT_FALSE(compiled.converts("other-tag"));
+}
+
+TEST(CompiledOptionsTest, Normalizes) {
+    markdownify::Options options;
+    options.bullets.clear();
+    options.max_depth = -3;
+    CompiledOptions compiled(options);
+
+    EXPECT_EQ(compiled.options().bullets, markdownify::Options().bullets);
+    EXPECT_EQ(compiled.options().max_depth, 0);
+
+    markdownify::MarkdownConverter converter(options);
+    EXPECT_EQ(converter.convert("<ul><li>a</li></ul>"), "* a");
+}
+
+TEST(CompiledOptionsTest, SharedBetweenConverters) {
+    markdownify::Options options;
+    options.strip_tags = {"a"};
+    auto compiled = std::make_shared<const CompiledOptions>(options);
+    markdownify::MarkdownConverter first(compiled);
+    markdownify::MarkdownConverter second(compiled);
+    std::string html = "<p><a href=\"x\">link</a></p>";
+
+    EXPECT_EQ(first.compiled_options(), second.compiled_options());
+    EXPECT_EQ(first.convert(html), markdownify::MarkdownConverter(options).convert(html));
+    EXPECT_EQ(second.convert(html), first.convert(html));
+
+    markdownify::ResultCache cache(1 << 20);
+    first.convert(html, cache);
+    second.convert(html, cache);
+    EXPECT_EQ(cache.stats().hits, 1u);
+}
+
+TEST(CompiledOptionsTest, KeepInlineImagesIn) {
+    std::string html = "<table><tr><td><img src=\"a.png\" alt=\"A\"></td></tr></table>";
+    markdownify::Options options;
+    markdownify::MarkdownConverter plain(options);
+    options.keep_inline_images_in = {"TD"};
+    markdownify::MarkdownConverter keeping(options);
+
+    EXPECT_EQ(plain.convert(html).find("!["), std::string::npos);
+    EXPECT_NE(keeping.convert(html).find("![A](a.png)"), std::string::npos);
+    EXPECT_EQ(keeping.convert("<h1><img src=\"a.png\" alt=\"A\"></h1>"),
+              plain.convert("<h1><img src=\"a.png\" alt=\"A\"></h1>"));
+}
+
+TEST(CompiledOptionsTest, TagActions) {
+    markdownify::Options options;
+    options.strip_tags = {"b", "custom-tag"};
+    options.tag_actions = {{"B", markdownify::TagAction::UNWRAP},
+                           {"script", markdownify::TagAction::CONVERT},
+                           {"other-tag", markdownify::TagAction::SKIP}};
+    CompiledOptions compiled(options);
+
+    EXPECT_EQ(compiled.action(TagId::B), markdownify::TagAction::UNWRAP);
+    EXPECT_EQ(compiled.action(TagId::SCRIPT), markdownify::TagAction::CONVERT);
+    EXPECT_EQ(compiled.action(TagId::STYLE), markdownify::TagAction::SKIP);
+    EXPECT_EQ(compiled.action(TagId::I), markdownify::TagAction::CONVERT);
+    EXPECT_EQ(compiled.action("custom-tag"), markdownify::TagAction::SKIP);
+    EXPECT_EQ(compiled.action("other-tag"), markdownify::TagAction::SKIP);
+    EXPECT_EQ(compiled.action("third-tag"), markdownify::TagAction::CONVERT);
+    EXPECT_FALSE(compiled.converts(TagId::B));
+    EXPECT_EQ(compiled.options().tag_actions.count("b"), 1u);
+}
@@ -20,6 +20,30 @@ TEST(ConversionsTest, ConvertTags) {
     EXPECT_TRUE(result.find("*Italic*") == std::string::npos);
 }
 
+TEST(ConversionsTest, TagActions) {
+    markdownify::Options options;
+    options.tag_actions = {{"a", markdownify::TagAction::UNWRAP},
+                           {"nav", markdownify::TagAction::SKIP},
+                           {"x-note", markdownify::TagAction::UNWRAP}};
+    std::string html = "<nav><a href=\"/\">Home</a></nav>"
+                       "<p><b>Bold</b> <a href=\"http://example.com\">Link</a></p>"
+                       "<x-note><em>note</em></x-note>";
+    EXPECT_EQ(markdownify::markdownify(html, options), "**Bold** Link\n\n*note*");
+
+    // Unwrapping a table writes its rows inline; skipping overrides a handler.
+    options.tag_actions = {{"table", markdownify::TagAction::UNWRAP},
+                           {"b", markdownify::TagAction::SKIP}};
+    markdownify::MarkdownConverter converter(options);
+    converter.set_handler("b", [](const markdownify::HtmlNode&, std::string_view children,
+                                  const markdownify::ParentContext&,
+                                  markdownify::MarkdownWriter& out) { out.append(children); });
+    EXPECT_EQ(converter.convert("<table><tr><td>x<b>y</b></td></tr></table>"), "| x |");
+
+    options.tag_actions = {{"style", markdownify::TagAction::UNWRAP}};
+    EXPECT_EQ(markdownify::markdownify("<style>p { }</style><script>x()</script>", options),
+              "p { }");
+}
+
 TEST(ConversionsTest, UnderscoreEmphasis) {
     markdownify::Options options;
     options.strong_em_symbol = markdownify::StrongEmSymbol::UNDERSCORE;
@@ -75,6 +99,19 @@ TEST(ConversionsTest, LinkWithTitle) {
     EXPECT_TRUE(result.find("\"Example Site\"") != std::string::npos);
 }
 
+TEST(ConversionsTest, DefaultTitle) {
+    markdownify::Options options;
+    options.default_title = true;
+    EXPECT_EQ(markdownify::markdownify(R"(<a href="http://example.com">Link</a>)", options),
+              "[Link](http://example.com \"http://example.com\")");
+    EXPECT_EQ(markdownify::markdownify(R"(<a href="http://example.com" title="Site">Link</a>)",
+                                       options),
+              "[Link](http://example.com \"Site\")");
+    EXPECT_EQ(markdownify::markdownify(R"(<a href="http://example.com">http://example.com</a>)",
+                                       options),
+              "[http://example.com](http://example.com \"http://example.com\")");
+}
+
 TEST(ConversionsTest, ImageWithTitle) {
     std::string html = R"(<img src="image.png" alt="Image" title="Image Title">)";
     std::string result = markdownify::markdownify(html);
@@ -103,6 +140,20 @@ TEST(ConversionsTest, Strikethrough) {
     EXPECT_TRUE(result.find("~~Deleted text~~") != std::string::npos);
 }
 
+TEST(ConversionsTest, SubAndSupSymbols) {
+    std::string html = "<p>H<sub>2</sub>O and x<sup> 2 </sup>y<sub> </sub></p>";
+    EXPECT_EQ(markdownify::markdownify(html), "H2O and x 2 y");
+
+    markdownify::Options options;
+    options.sub_symbol = "~";
+    options.sup_symbol = "^";
+    EXPECT_EQ(markdownify::markdownify(html, options), "H~2~O and x ^2^ y");
+
+    options.sub_symbol = "<sub>";
+    options.sup_symbol = "<sup>";
+    EXPECT_EQ(markdownify::markdownify(html, options), "H<sub>2</sub>O and x <sup>2</sup> y");
+}
+
 TEST(ConversionsTest, ComplexDocument) {
     std::string html = R"(<h1>Title</h1>
 <p>This is a <strong>complex</strong> document with <em>various</em> elements.</p>
@@ -123,4 +174,46 @@ TEST(ConversionsTest, ComplexDocument) {
     EXPECT_TRUE(result.find("* List item 1") != std::string::npos);
     EXPECT_TRUE(result.find("[link](https://example.com)") != std::string::npos);
     EXPECT_TRUE(result.find("![Photo](photo.jpg)") != std::string::npos);
-}
\ No newline at end of file
+}
+
+TEST(ConversionsTest, DeepNesting) {
+    const int depth = 200000;
+    std::string html;
+    for (int i = 0; i < depth; ++i) html += "<span>";
+    html += "<b>deep</b>";
+    for (int i = 0; i < depth; ++i) html += "</span>";
+    EXPECT_EQ(markdownify::markdownify(html), "**deep**");
+}
+
+TEST(ConversionsTest, DeepBlockNesting) {
+    // Every <div> start tag checks for an open <p> to close.
+    const int depth = 200000;
+    std::string html;
+    for (int i = 0; i < depth; ++i) html += "<div>";
+    html += "<p>deep <b>text</b></p>";
+    for (int i = 0; i < depth; ++i) html += "</div>";
+    EXPECT_EQ(markdownify::markdownify(html), "deep **text**");
+
+    markdownify::Options options;
+    options.max_depth = 3;
+    EXPECT_EQ(markdownify::markdownify(html, options), "deep text");
+}
+
+TEST(ConversionsTest, MaxDepth) {
+    markdownify::Options options;
+    options.max_depth = 3;
+    std::string html = "<div><p>Keep <b>bold</b></p>"
+                       "<div><p>Flat <b>text</b><script>x()</script></p></div></div>";
+    std::string result = markdownify::markdownify(html, options);
+    EXPECT_EQ(result, "Keep **bold**\n\n\n\nFlat text");
+}
+
+TEST(ConversionsTest, Wrap) {
+    markdownify::Options options;
+    options.wrap = true;
+    options.wrap_width = 20;
+    std::string html = "<p>A <a href=\"http://example.com\">long link text</a> then\n"
+                       "more words<br>after a break</p>";
+    std::string result = markdownify::markdownify(html, options);
+    EXPECT_EQ(result, "A\n[long link text](http://example.com)\nthen more words  \nafter a break");
+}
@@ -0,0 +1,101 @@
+#include <markdownify/markdownify.hpp>
+#include <gtest/gtest.h>
+
+using markdownify::HtmlNode;
+using markdownify::MarkdownWriter;
+using markdownify::ParentContext;
+
+namespace {
+
+void mark(const HtmlNode&, std::string_view children, const ParentContext&,
+          MarkdownWriter& out) {
+    out.append("==");
+    out.append(children);
+    out.append("==");
+}
+
+}
+
+TEST(CustomHandlersTest, KnownAndUnknownTags) {
+    markdownify::MarkdownConverter converter;
+    EXPECT_TRUE(converter.set_handler("mark", mark));
+    EXPECT_TRUE(converter.set_handler("CMS-Callout", [](const HtmlNode& element,
+                                                        std::string_view children,
+                                                        const ParentContext&,
+                                                        MarkdownWriter& out) {
+        out.append("\n\n> **");
+        out.append(element.attribute("kind"));
+        out.append(":** ");
+        out.append(children);
+        out.append("\n\n");
+    }));
+
+    EXPECT_EQ(converter.convert("<p>a <mark>b <b>c</b></mark> d</p>"), "a ==b **c**== d");
+    EXPECT_EQ(converter.convert("<cms-callout kind=\"Note\">Read <i>this</i></cms-callout>"),
+              "> **Note:** Read *this*");
+    EXPECT_EQ(converter.convert("<other-tag>kept</other-tag>"), "kept");
+}
+
+TEST(CustomHandlersTest, ReplacesBuiltInHandler) {
+    markdownify::MarkdownConverter converter;
+    EXPECT_TRUE(converter.set_handler("b", mark));
+    EXPECT_EQ(converter.convert("<b>x</b>"), "==x==");
+    EXPECT_TRUE(converter.set_handler("b", [](const HtmlNode&, std::string_view children,
+                                              const ParentContext&, MarkdownWriter& out) {
+        out.append(children);
+    }));
+    EXPECT_EQ(converter.convert("<b>x</b>"), "x");
+}
+
+TEST(CustomHandlersTest, NestedElementsAndContext) {
+    markdownify::MarkdownConverter converter;
+    converter.set_handler("details", [](const HtmlNode&, std::string_view children,
+                                        const ParentContext& context, MarkdownWriter& out) {
+        out.append("[");
+        out.append(std::to_string(context.has(markdownify::TagId::DETAILS)));
+        out.append(":");
+        out.append(children);
+        out.append("]");
+    });
+    EXPECT_EQ(converter.convert("<details>a<details>b</details>c</details>"), "[0:a[1:b]c]");
+}
+
+TEST(CustomHandlersTest, TableParts) {
+    markdownify::MarkdownConverter converter;
+    EXPECT_FALSE(converter.set_handler("tr", mark));
+    EXPECT_FALSE(converter.set_handler("", mark));
+    EXPECT_FALSE(converter.set_handler("mark", nullptr));
+    EXPECT_TRUE(converter.set_handler("td", mark));
+
+    std::string html = "<table><tr><th>H</th></tr><tr><td>x</td></tr></table>";
+    EXPECT_EQ(converter.convert(html), "| H |\n| --- |\n| ==x== |");
+
+    EXPECT_TRUE(converter.set_handler("table", [](const HtmlNode&, std::string_view children,
+                                                  const ParentContext&, MarkdownWriter& out) {
+        out.append("<<");
+        out.append(children);
+        out.append(">>");
+    }));
+    EXPECT_EQ(converter.convert(html), "<<| H | \n| ==x== | \n>>");
+}
+
+TEST(CustomHandlersTest, CachedResultsFollowHandlers) {
+    markdownify::MarkdownConverter plain;
+    markdownify::MarkdownConverter custom;
+    custom.set_handler("mark", mark);
+    markdownify::ResultCache cache(1 << 20);
+    std::string html = "<mark>x</mark>";
+
+    EXPECT_EQ(plain.convert(html, cache), "x");
+    EXPECT_EQ(custom.convert(html, cache), "==x==");
+
+    markdownify::SubtreeCache subtrees;
+    std::string page = "<div><p><mark>a <i>b</i> c</mark></p></div>";
+    EXPECT_EQ(custom.convert(page, subtrees), "==a *b* c==");
+    custom.set_handler("mark", [](const HtmlNode&, std::string_view children,
+                                  const ParentContext&, MarkdownWriter& out) {
+        out.append(children);
+    });
+    EXPECT_EQ(custom.convert(page, subtrees), "a *b* c");
+    EXPECT_EQ(subtrees.reused_count(), 0u);
+}
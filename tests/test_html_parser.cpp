@@ -0,0 +1,134 @@
+#include <markdownify/html_parser.hpp>
+#include <markdownify/markdownify.hpp>
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string round_trip(const std::string& html) {
+    markdownify::HtmlDocument doc;
+    markdownify::HtmlParser parser(doc);
+    parser.parse(html);
+
+    std::string result;
+    for (auto child = doc.root()->first_child; child; child = child->next_sibling) {
+        result += markdownify::to_html(child);
+    }
+    return result;
+}
+
+}
+
+TEST(HtmlParserTest, VoidElements) {
+    EXPECT_EQ(round_trip("<p>a<br>b<img src=x.png>c</p>"),
+              "<p>a<br>b<img src=\"x.png\">c</p>");
+}
+
+TEST(HtmlParserTest, ImpliedEndTags) {
+    EXPECT_EQ(round_trip("<p>one<p>two"), "<p>one</p><p>two</p>");
+    EXPECT_EQ(round_trip("<ul><li>a<li>b</ul>"), "<ul><li>a</li><li>b</li></ul>");
+    EXPECT_EQ(round_trip("<table><tr><td>1<td>2<tr><td>3</table>"),
+              "<table><tr><td>1</td><td>2</td></tr><tr><td>3</td></tr></table>");
+    EXPECT_EQ(round_trip("<p>text<div>block</div>"), "<p>text</p><div>block</div>");
+}
+
+TEST(HtmlParserTest, UnquotedAndUppercaseAttributes) {
+    EXPECT_EQ(round_trip("<A HREF=/path Title='t'>x</A>"),
+              "<a href=\"/path\" title=\"t\">x</a>");
+}
+
+TEST(HtmlParserTest, RawTextElements) {
+    EXPECT_EQ(round_trip("<script>if (a<b && c) {}</script>"),
+              "<script>if (a&lt;b &amp;&amp; c) {}</script>");
+    EXPECT_EQ(round_trip("<style>p > a { }</STYLE>x"), "<style>p &gt; a { }</style>x");
+}
+
+TEST(HtmlParserTest, StrayAndUnclosedTags) {
+    EXPECT_EQ(round_trip("a</b>c"), "ac");
+    EXPECT_EQ(round_trip("<div><b>bold</div>after"), "<div><b>bold</b></div>after");
+    EXPECT_EQ(round_trip("<p>cut <b"), "<p>cut </p>");
+}
+
+TEST(HtmlParserTest, CommentsAndDoctype) {
+    EXPECT_EQ(round_trip("<!DOCTYPE html><!-- note -->text"), "text");
+}
+
+TEST(HtmlParserTest, Entities) {
+    EXPECT_EQ(round_trip("a &amp; b &lt;c&gt; &#65;&#x42; &unknown;"),
+              "a &amp; b &lt;c&gt; AB &amp;unknown;");
+}
+
+TEST(HtmlParserTest, NamedEntities) {
+    std::string out;
+    markdownify::decode_entities("&nbsp;&mdash;&eacute;&Eacute;&frac12;&NotNestedLessLess;", out);
+    EXPECT_EQ(out, "\u00A0\u2014\u00E9\u00C9\u00BD\u2AA1\u0338");
+
+    out.clear();
+    markdownify::decode_entities("&copy 2024 &ampx &notit; &notin; &nbspx &Copy &fakeent; &", out);
+    EXPECT_EQ(out, "\u00A9 2024 &x \u00ACit; \u2209 \u00A0x &Copy &fakeent; &");
+}
+
+TEST(HtmlParserTest, LegacyEntitiesInAttributes) {
+    markdownify::HtmlDocument doc;
+    markdownify::HtmlParser(doc).parse(
+        "<a href=\"?a=1&copy=2&lang=en&copy;\" title=\"&copy 2024\">x</a>");
+    const markdownify::HtmlNode* a = doc.root()->first_child;
+    EXPECT_EQ(a->attribute("href"), "?a=1&copy=2&lang=en\u00A9");
+    EXPECT_EQ(a->attribute("title"), "\u00A9 2024");
+}
+
+TEST(HtmlParserTest, MalformedDocumentStillConverts) {
+    std::string html = "<p>First <b>bold <i>both</b> rest<p>Second & <a href=x>link";
+    std::string result = markdownify::markdownify(html);
+    EXPECT_TRUE(result.find("First **bold *both***") != std::string::npos);
+    EXPECT_TRUE(result.find("Second & [link](x)") != std::string::npos);
+}
+
+TEST(HtmlParserTest, InternsTagNames) {
+    static_assert(markdownify::lookup_tag("blockquote") == markdownify::TagId::BLOCKQUOTE);
+    static_assert(markdownify::lookup_tag("h7") == markdownify::TagId::UNKNOWN);
+    for (std::size_t id = 1; id < markdownify::kTagCount; ++id) {
+        auto tag = static_cast<markdownify::TagId>(id);
+        EXPECT_EQ(markdownify::lookup_tag(markdownify::tag_name(tag)), tag);
+    }
+
+    markdownify::HtmlDocument doc;
+    markdownify::HtmlParser(doc).parse("<DIV><my-widget>x</my-widget></DIV>");
+    const markdownify::HtmlNode* div = doc.root()->first_child;
+    EXPECT_EQ(div->tag, markdownify::TagId::DIV);
+    EXPECT_EQ(div->first_child->tag, markdownify::TagId::UNKNOWN);
+    EXPECT_EQ(div->first_child->name, "my-widget");
+    EXPECT_EQ(div->first_child->first_child->tag, markdownify::TagId::UNKNOWN);
+}
+
+TEST(HtmlParserTest, ParseInPlaceBorrowsPlainText) {
+    std::string html = "<p title=\"plain\" alt=\"a &amp; b\">plain <b>bold</b> x &lt; y</p>"
+                       "<script>a\r\nb</script><p>one<!-- c -->two</p>";
+    auto in_input = [&](std::string_view value) {
+        return value.data() >= html.data() && value.data() < html.data() + html.size();
+    };
+
+    markdownify::HtmlDocument doc;
+    markdownify::HtmlParser(doc).parse_in_place(html);
+
+    const markdownify::HtmlNode* p = doc.root()->first_child;
+    EXPECT_TRUE(in_input(p->attribute("title")));
+    EXPECT_FALSE(in_input(p->attribute("alt")));
+    EXPECT_EQ(p->attribute("alt"), "a & b");
+
+    const markdownify::HtmlNode* plain = p->first_child;
+    EXPECT_TRUE(in_input(plain->value));
+    EXPECT_EQ(plain->value, "plain ");
+    EXPECT_EQ(plain->next_sibling->next_sibling->value, " x < y");
+
+    const markdownify::HtmlNode* script = p->next_sibling;
+    EXPECT_EQ(script->first_child->value, "a\nb");
+
+    const markdownify::HtmlNode* joined = script->next_sibling->first_child;
+    EXPECT_EQ(joined->value, "onetwo");
+    EXPECT_EQ(joined->next_sibling, nullptr);
+
+    markdownify::HtmlDocument copied;
+    markdownify::HtmlParser(copied).parse(html);
+    EXPECT_EQ(markdownify::to_html(doc.root()->first_child),
+              markdownify::to_html(copied.root()->first_child));
+}
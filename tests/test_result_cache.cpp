@@ -0,0 +1,104 @@
+#include <markdownify/markdownify.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+
+TEST(ResultCacheTest, HitReturnsStoredMarkdown) {
+    markdownify::MarkdownConverter converter;
+    markdownify::ResultCache cache(1 << 20);
+    std::string html = "<h1>Title</h1><p>Some <b>bold</b> text</p>";
+
+    EXPECT_EQ(converter.convert(html, cache), converter.convert(html));
+    EXPECT_EQ(converter.convert(html, cache), converter.convert(html));
+
+    markdownify::ResultCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.entry_count, 1u);
+    EXPECT_GT(stats.bytes, converter.convert(html).size());
+}
+
+TEST(ResultCacheTest, OptionsAreKeyed) {
+    markdownify::Options dashes;
+    dashes.bullets = {"-"};
+    markdownify::Options stripped;
+    stripped.strip_tags = {"b"};
+    markdownify::MarkdownConverter plain;
+    markdownify::MarkdownConverter plain_too;
+    markdownify::MarkdownConverter with_dashes(dashes);
+    markdownify::MarkdownConverter with_stripped(stripped);
+    markdownify::ResultCache cache(1 << 20);
+    std::string html = "<ul><li><b>a</b></li></ul>";
+
+    EXPECT_EQ(plain.convert(html, cache), "* **a**");
+    EXPECT_EQ(with_dashes.convert(html, cache), "- **a**");
+    EXPECT_EQ(with_stripped.convert(html, cache), with_stripped.convert(html));
+    EXPECT_EQ(plain_too.convert(html, cache), "* **a**");
+
+    markdownify::ResultCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(stats.hits, 1u);
+}
+
+TEST(ResultCacheTest, EvictsLeastRecentlyUsed) {
+    markdownify::MarkdownConverter converter;
+    std::string a = "<p>" + std::string(100, 'a') + "</p>";
+    std::string b = "<p>" + std::string(100, 'b') + "</p>";
+    std::string c = "<p>" + std::string(100, 'c') + "</p>";
+    // Room for two entries.
+    markdownify::ResultCache cache(600, 1);
+
+    converter.convert(a, cache);
+    converter.convert(b, cache);
+    converter.convert(a, cache);
+    converter.convert(c, cache);
+    EXPECT_EQ(cache.stats().evictions, 1u);
+
+    converter.convert(a, cache);
+    EXPECT_EQ(cache.stats().hits, 2u);
+    converter.convert(b, cache);
+    EXPECT_EQ(cache.stats().hits, 2u);
+    EXPECT_LE(cache.stats().bytes, cache.capacity());
+}
+
+TEST(ResultCacheTest, TooLargeToStore) {
+    markdownify::MarkdownConverter converter;
+    markdownify::ResultCache cache(1000, 4);
+    std::string html = "<p>" + std::string(500, 'x') + "</p>";
+
+    EXPECT_EQ(converter.convert(html, cache), std::string(500, 'x'));
+    EXPECT_EQ(cache.stats().entry_count, 0u);
+}
+
+TEST(ResultCacheTest, SharedBetweenThreads) {
+    markdownify::MarkdownConverter converter;
+    markdownify::ResultCache cache(1 << 20, 4);
+    std::vector<std::string> pages;
+    for (int i = 0; i < 20; ++i) {
+        pages.push_back("<p>Page <b>" + std::to_string(i) + "</b></p>");
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int round = 0; round < 50; ++round) {
+                for (std::size_t i = 0; i < pages.size(); ++i) {
+                    std::string expected = "Page **" + std::to_string(i) + "**";
+                    if (converter.convert(pages[i], cache) != expected) {
+                        ++failures[t];
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (int f : failures) {
+        EXPECT_EQ(f, 0);
+    }
+    markdownify::ResultCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits + stats.misses, 4u * 50u * 20u);
+    EXPECT_EQ(stats.entry_count, 20u);
+}
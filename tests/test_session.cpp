@@ -0,0 +1,91 @@
+#include <markdownify/markdownify.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Every heap allocation in this test binary goes through these; counting
+// is switched on only around the code under test.
+namespace {
+
+std::atomic<bool> counting{false};
+std::atomic<std::size_t> allocations{0};
+
+struct AllocationCounter {
+    AllocationCounter() {
+        allocations = 0;
+        counting = true;
+    }
+    ~AllocationCounter() { counting = false; }
+
+    std::size_t count() const { return allocations.load(); }
+};
+
+}
+
+void* operator new(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+const char* kDocument =
+    "<html><head><title>Release notes</title><style>p { color: red; }</style></head><body>"
+    "<h1>Release <em>notes</em></h1>"
+    "<p>This release fixes <strong>several</strong> bugs in <code>parse_options()</code> "
+    "and adds a <a href=\"https://example.com/docs\" title=\"Docs\">new guide</a>.</p>"
+    "<ul><li>Faster <b>tables</b></li><li>Nested lists<ol><li>one</li><li>two</li></ol></li></ul>"
+    "<blockquote><p>Quoted text with snake_case and *stars*.</p></blockquote>"
+    "<pre><code class=\"language-cpp\">int main() {\n    return 0;\n}</code></pre>"
+    "<table><tr><th>Name</th><th>Value</th></tr><tr><td>a</td><td>1</td></tr></table>"
+    "<p>Line one<br>Line two &amp; more &lt;text&gt;</p><hr>"
+    "<img src=\"/logo.png\" alt=\"Logo\">"
+    "</body></html>";
+
+}
+
+TEST(SessionTest, MatchesConverter) {
+    markdownify::ConversionSession session;
+    EXPECT_EQ(session.convert(kDocument), markdownify::markdownify(kDocument));
+    EXPECT_EQ(session.convert("<p>second</p>"), "second");
+    EXPECT_EQ(session.convert(""), "");
+    EXPECT_EQ(session.convert(kDocument), markdownify::markdownify(kDocument));
+}
+
+TEST(SessionTest, SharesConverter) {
+    markdownify::Options options;
+    options.heading_style = markdownify::HeadingStyle::ATX;
+    const markdownify::MarkdownConverter converter(options);
+
+    markdownify::ConversionSession first(converter);
+    markdownify::ConversionSession second(converter);
+    EXPECT_EQ(first.convert("<h2>Title</h2>"), "## Title");
+    EXPECT_EQ(second.convert("<h2>Title</h2>"), "## Title");
+}
+
+TEST(SessionTest, SteadyStateDoesNotAllocate) {
+    markdownify::ConversionSession session;
+    for (int i = 0; i < 3; ++i) {
+        session.convert(kDocument);
+    }
+
+    AllocationCounter counter;
+    for (int i = 0; i < 10; ++i) {
+        session.convert(kDocument);
+    }
+    EXPECT_EQ(counter.count(), 0u);
+}
@@ -0,0 +1,73 @@
+#include "simd_scan.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+using markdownify::detail::ByteSet;
+using markdownify::detail::SimdLevel;
+using markdownify::detail::detected_simd_level;
+using markdownify::detail::find_first_in_set;
+
+namespace {
+
+std::vector<SimdLevel> supported_levels() {
+    std::vector<SimdLevel> levels;
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level <= detected_simd_level()) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+}
+
+TEST(SimdScanTest, ByteSetMembership) {
+    ByteSet set("*_-#&");
+    EXPECT_TRUE(set.contains('*'));
+    EXPECT_TRUE(set.contains('&'));
+    EXPECT_FALSE(set.contains('a'));
+    EXPECT_FALSE(set.contains(0));
+    EXPECT_FALSE(set.contains(0xaa));
+    EXPECT_EQ(set.member_count(), 5u);
+}
+
+TEST(SimdScanTest, FindsFirstMemberAtEveryOffset) {
+    ByteSet set("_&");
+    for (SimdLevel level : supported_levels()) {
+        for (std::size_t size : {0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 200}) {
+            std::string text(size, 'a');
+            EXPECT_EQ(find_first_in_set(text.data(), size, set, level), size);
+            for (std::size_t pos = 0; pos < size; ++pos) {
+                text.assign(size, 'a');
+                text[pos] = '&';
+                if (pos + 1 < size) {
+                    text[pos + 1] = '_';
+                }
+                EXPECT_EQ(find_first_in_set(text.data(), size, set, level), pos)
+                    << static_cast<int>(level) << " " << size;
+            }
+        }
+    }
+}
+
+TEST(SimdScanTest, KernelsAgreeOnRandomBytes) {
+    ByteSet set("-#*_0123456789");
+    std::mt19937 rng(7);
+    for (int iter = 0; iter < 2000; ++iter) {
+        std::string text(rng() % 300, '\0');
+        for (char& c : text) {
+            // Mostly non-members, including bytes >= 0x80 whose low nibble
+            // matches a member.
+            switch (rng() % 16) {
+                case 0: c = "-#*_7"[rng() % 5]; break;
+                case 1: case 2: case 3: c = static_cast<char>(0x80 | (rng() % 128)); break;
+                default: c = static_cast<char>('a' + rng() % 26); break;
+            }
+        }
+        std::size_t expected = find_first_in_set(text.data(), text.size(), set, SimdLevel::SCALAR);
+        for (SimdLevel level : supported_levels()) {
+            EXPECT_EQ(find_first_in_set(text.data(), text.size(), set, level), expected);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#include <markdownify/markdownify.hpp>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <sstream>
+
+namespace {
+
+// Enough top-level blocks, some inside transparent containers, to be passed
+// on in several chunks.
+std::string long_document() {
+    std::string html = "<html><body>\n";
+    for (int i = 0; i < 2000; ++i) {
+        html += "<div><h2>Section " + std::to_string(i) + "</h2>\n<p>Some <b>bold</b> text.</p>\n";
+        html += "<ul><li>one</li><li>two</li></ul></div>\n";
+    }
+    return html + "\n</body></html>\n";
+}
+
+std::vector<std::string> collect(const markdownify::MarkdownConverter& converter,
+                                 const std::string& html) {
+    std::vector<std::string> chunks;
+    converter.convert(html, [&chunks](std::string_view chunk) { chunks.emplace_back(chunk); });
+    return chunks;
+}
+
+std::string join(const std::vector<std::string>& chunks) {
+    std::string result;
+    for (const std::string& chunk : chunks) {
+        result += chunk;
+    }
+    return result;
+}
+
+}
+
+TEST(SinkTest, ChunksConcatenateToConvert) {
+    markdownify::MarkdownConverter converter;
+    std::string html = long_document();
+    std::vector<std::string> chunks = collect(converter, html);
+
+    EXPECT_GT(chunks.size(), 1u);
+    EXPECT_EQ(join(chunks), converter.convert(html));
+    EXPECT_EQ(join(collect(converter, "<p>short</p>")), "short");
+    EXPECT_TRUE(collect(converter, "").empty());
+    EXPECT_TRUE(collect(converter, "<div> \n </div>").empty());
+}
+
+TEST(SinkTest, StripsAtTheBoundary) {
+    std::string html = "\n<p>first</p>" + long_document() + "<p>last</p>\n<div>\n\n</div>";
+    for (auto mode : {markdownify::StripMode::NONE, markdownify::StripMode::LSTRIP,
+                      markdownify::StripMode::RSTRIP, markdownify::StripMode::STRIP}) {
+        markdownify::Options options;
+        options.strip_document = mode;
+        markdownify::MarkdownConverter converter(options);
+        EXPECT_EQ(join(collect(converter, html)), converter.convert(html));
+    }
+}
+
+TEST(SinkTest, SoupAndMaxDepth) {
+    markdownify::Options options;
+    options.max_depth = 2;
+    markdownify::MarkdownConverter converter(options);
+    std::string html = "<div><div><p>deep <b>text</b></p></div></div><p>top</p>";
+
+    markdownify::HtmlDocument doc;
+    markdownify::HtmlParser parser(doc);
+    parser.parse_in_place(html);
+    std::string result;
+    converter.convert_soup(doc, [&result](std::string_view chunk) { result += chunk; });
+    EXPECT_EQ(result, converter.convert(html));
+}
+
+TEST(SinkTest, Ostream) {
+    markdownify::MarkdownConverter converter;
+    std::string html = long_document();
+    std::ostringstream out;
+
+    EXPECT_TRUE(converter.convert(html, out));
+    EXPECT_EQ(out.str(), converter.convert(html));
+
+    std::ostringstream failed;
+    failed.setstate(std::ios::badbit);
+    EXPECT_FALSE(converter.convert(html, failed));
+}
+
+TEST(SinkTest, FileDescriptor) {
+    markdownify::MarkdownConverter converter;
+    std::string html = long_document();
+    std::FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+
+    EXPECT_TRUE(converter.convert_to_fd(html, fileno(file)));
+    std::rewind(file);
+    std::string written;
+    char buffer[4096];
+    while (std::size_t n = std::fread(buffer, 1, sizeof(buffer), file)) {
+        written.append(buffer, n);
+    }
+    std::fclose(file);
+    EXPECT_EQ(written, converter.convert(html));
+
+    EXPECT_FALSE(converter.convert_to_fd(html, -1));
+}
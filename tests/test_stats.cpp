@@ -0,0 +1,52 @@
+#include <markdownify/markdownify.hpp>
+#include <gtest/gtest.h>
+
+TEST(StatsTest, CountsDocument) {
+    std::string html = "<p>Some <b>bold</b> text</p><ul><li>a<ul><li>b</li></ul></li></ul>";
+    markdownify::MarkdownConverter converter;
+    markdownify::ConversionStats stats;
+
+    std::string markdown = converter.convert(html, stats);
+    EXPECT_EQ(markdown, converter.convert(html));
+    EXPECT_EQ(stats.input_bytes, html.size());
+    EXPECT_EQ(stats.output_bytes, markdown.size());
+    EXPECT_EQ(stats.element_count, 6u);
+    EXPECT_EQ(stats.text_node_count, 5u);
+    EXPECT_EQ(stats.max_depth, 5u);
+    EXPECT_GT(stats.arena_blocks, 0u);
+    EXPECT_GE(stats.walk_time, stats.escape_time);
+    EXPECT_GT(stats.parse_time.count(), 0);
+}
+
+TEST(StatsTest, EmptyDocument) {
+    markdownify::MarkdownConverter converter;
+    markdownify::ConversionStats stats;
+    stats.element_count = 42;
+
+    EXPECT_EQ(converter.convert("", stats), "");
+    EXPECT_EQ(stats.element_count, 0u);
+    EXPECT_EQ(stats.max_depth, 0u);
+    EXPECT_EQ(stats.output_bytes, 0u);
+}
+
+TEST(StatsTest, SessionReportsArenaGrowth) {
+    std::string small = "<p>x</p>";
+    std::string large;
+    for (int i = 0; i < 2000; ++i) {
+        large += "<p>paragraph <i>" + std::to_string(i) + "</i></p>";
+    }
+
+    markdownify::ConversionSession session;
+    markdownify::ConversionStats stats;
+    session.convert(large, stats);
+    EXPECT_GT(stats.arena_blocks, 0u);
+    EXPECT_EQ(stats.element_count, 4000u);
+
+    session.convert(small, stats);
+    EXPECT_EQ(stats.arena_blocks, 0u);
+    EXPECT_EQ(stats.element_count, 1u);
+    EXPECT_EQ(stats.max_depth, 2u);
+
+    session.convert(large, stats);
+    EXPECT_EQ(stats.arena_blocks, 0u);
+}
@@ -0,0 +1,76 @@
+#include <markdownify/markdownify.hpp>
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string stream_in_chunks(const std::string& html, std::size_t chunk_size,
+                             const markdownify::Options& options = markdownify::Options()) {
+    markdownify::StreamingConverter converter(options);
+    std::string result;
+    for (std::size_t pos = 0; pos < html.size(); pos += chunk_size) {
+        result += converter.feed(std::string_view(html).substr(pos, chunk_size));
+    }
+    result += converter.finish();
+    return result;
+}
+
+const char* const kDocument = R"(<!DOCTYPE html>
+<html><head><title>T &amp; t</title><style>p { color: red }</style></head>
+<body>
+<div class="content">
+<h1>Title</h1>
+<p>This is a <strong>complex</strong> document &amp; more.</p>
+<ul>
+<li>One</li>
+<li>Two<ol><li>a</li><li>b</li></ol></li>
+</ul>
+<pre><code>int x = 1;
+</code></pre>
+<table><tr><th>A</th><th>B</th></tr><tr><td>1</td><td>2</td></tr></table>
+<p>A <a href="https://example.com">link</a> and <img src="i.png" alt="img"></p>
+<script>if (a < b) { document.write("</p>"); }</script>
+</div>
+</body></html>)";
+
+}
+
+TEST(StreamingTest, MatchesConvertForAnyChunkSize) {
+    std::string expected = markdownify::markdownify(kDocument);
+    for (std::size_t chunk_size : {1, 2, 3, 7, 16, 100, 10000}) {
+        EXPECT_EQ(stream_in_chunks(kDocument, chunk_size), expected) << chunk_size;
+    }
+}
+
+TEST(StreamingTest, MatchesConvertWithoutDocumentStrip) {
+    markdownify::Options options;
+    options.strip_document = markdownify::StripMode::NONE;
+    std::string expected = markdownify::MarkdownConverter(options).convert(kDocument);
+    EXPECT_EQ(stream_in_chunks(kDocument, 5, options), expected);
+}
+
+TEST(StreamingTest, EmitsBlocksBeforeFinish) {
+    markdownify::StreamingConverter converter;
+    EXPECT_EQ(converter.feed("<html><body><p>First</p><p>Sec"), "First");
+    EXPECT_EQ(converter.feed("ond</p><p>Third"), "\n\n\n\nSecond");
+    EXPECT_EQ(converter.finish(), "\n\n\n\nThird");
+}
+
+TEST(StreamingTest, LongWrappedDocument) {
+    std::string html = "<html><body><div>";
+    for (int i = 0; i < 5000; ++i) {
+        html += "<p>Paragraph " + std::to_string(i) + " with <em>text</em></p>\n";
+    }
+    html += "</div></body></html>";
+
+    EXPECT_EQ(stream_in_chunks(html, 4096), markdownify::markdownify(html));
+}
+
+TEST(StreamingTest, ConverterIsReusableAfterFinish) {
+    markdownify::StreamingConverter converter;
+    converter.feed("<p>one</p><ul><li>x");
+    converter.finish();
+
+    std::string result = converter.feed("<b>two</b>");
+    result += converter.finish();
+    EXPECT_EQ(result, "**two**");
+}
@@ -0,0 +1,96 @@
+#include <markdownify/markdownify.hpp>
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string page(const std::string& intro, const std::string& items) {
+    return "<html><body>"
+           "<h1>Title <em>here</em></h1>"
+           "<p>" + intro + " with <b>bold</b> and <a href=\"/x\">a link</a>.</p>"
+           "<ol>" + items + "<li>Last <i>item</i> <b>here</b></li></ol>"
+           "<table><tr><th>A <b>x</b></th><th>B</th></tr>"
+           "<tr><td><p>one <i>1</i> <b>2</b></p></td><td>two</td></tr></table>"
+           "<blockquote><p>Quoted <b>text</b> and <i>more</i></p></blockquote>"
+           "</body></html>";
+}
+
+}
+
+TEST(SubtreeCacheTest, EditedParagraphIsConvertedAgain) {
+    markdownify::MarkdownConverter converter;
+    markdownify::SubtreeCache cache;
+
+    std::string first = page("Intro", "<li>One <b>1</b> <i>x</i></li>");
+    EXPECT_EQ(converter.convert(first, cache), converter.convert(first));
+    EXPECT_EQ(cache.reused_count(), 0u);
+    EXPECT_GT(cache.stored_count(), 0u);
+
+    std::string second = page("Changed intro", "<li>One <b>1</b> <i>x</i></li>");
+    EXPECT_EQ(converter.convert(second, cache), converter.convert(second));
+    EXPECT_GT(cache.reused_count(), 0u);
+}
+
+TEST(SubtreeCacheTest, UnchangedDocumentIsReusedWhole) {
+    markdownify::MarkdownConverter converter;
+    markdownify::SubtreeCache cache;
+    std::string html = page("Intro", "");
+
+    std::string expected = converter.convert(html, cache);
+    EXPECT_EQ(converter.convert(html, cache), expected);
+    EXPECT_EQ(cache.reused_count(), 1u);
+    EXPECT_EQ(cache.stored_count(), 0u);
+}
+
+TEST(SubtreeCacheTest, ListNumbersFollowInsertedItems) {
+    markdownify::MarkdownConverter converter;
+    markdownify::SubtreeCache cache;
+
+    std::string items = "<li>Two <b>2</b> <i>b</i></li><li>Three <b>3</b> <i>c</i></li>";
+    converter.convert(page("Intro", items), cache);
+
+    std::string inserted = page("Intro", "<li>One <b>1</b> <i>a</i></li>" + items);
+    EXPECT_EQ(converter.convert(inserted, cache), converter.convert(inserted));
+
+    std::string removed = page("Intro", "<li>Three <b>3</b> <i>c</i></li>");
+    EXPECT_EQ(converter.convert(removed, cache), converter.convert(removed));
+}
+
+TEST(SubtreeCacheTest, EditedTableCell) {
+    markdownify::MarkdownConverter converter;
+    markdownify::SubtreeCache cache;
+
+    std::string html = "<div><table><tr><th><span>A <b>x</b> y</span></th>"
+                       "<th><span>B <b>y</b> z</span></th></tr>"
+                       "<tr><td><span>1 <b>1</b> 1</span></td>"
+                       "<td><span>2 <b>2</b> 2</span></td></tr></table></div>";
+    converter.convert(html, cache);
+
+    std::string edited = html;
+    edited.replace(edited.find("2 <b>2</b>"), 1, "22");
+    EXPECT_EQ(converter.convert(edited, cache),
+              "| A **x** y | B **y** z |\n| --- | --- |\n| 1 **1** 1 | 22 **2** 2 |");
+    EXPECT_GT(cache.reused_count(), 0u);
+}
+
+TEST(SubtreeCacheTest, ContextIsPartOfTheKey) {
+    markdownify::MarkdownConverter converter;
+    markdownify::SubtreeCache cache;
+    std::string inner = "<span>a_b <b>c</b> <i>d</i></span>";
+
+    converter.convert("<p>" + inner + "</p>", cache);
+    std::string moved = "<pre>" + inner + "</pre><h2>" + inner + "</h2>";
+    EXPECT_EQ(converter.convert(moved, cache), converter.convert(moved));
+}
+
+TEST(SubtreeCacheTest, CacheFollowsItsConverter) {
+    markdownify::Options options;
+    options.strong_em_symbol = markdownify::StrongEmSymbol::UNDERSCORE;
+    markdownify::MarkdownConverter asterisks;
+    markdownify::MarkdownConverter underscores(options);
+    markdownify::SubtreeCache cache;
+    std::string html = page("Intro", "");
+
+    asterisks.convert(html, cache);
+    EXPECT_EQ(underscores.convert(html, cache), underscores.convert(html));
+    EXPECT_EQ(cache.reused_count(), 0u);
+}
@@ -0,0 +1,62 @@
+#include <markdownify/markdownify.hpp>
+#include <gtest/gtest.h>
+
+TEST(TablesTest, HeaderRow) {
+    std::string html = "<table><thead><tr><th>A</th><th>B</th></tr></thead>"
+                       "<tbody><tr><td>1</td><td>2</td></tr></tbody></table>";
+    EXPECT_EQ(markdownify::markdownify(html), "| A | B |\n| --- | --- |\n| 1 | 2 |");
+}
+
+TEST(TablesTest, MissingHeaderRow) {
+    std::string html = "<table><tr><td>1</td><td>2</td></tr><tr><td>3</td><td>4</td></tr></table>";
+    EXPECT_EQ(markdownify::markdownify(html),
+              "|  |  |\n| --- | --- |\n| 1 | 2 |\n| 3 | 4 |");
+
+    markdownify::Options options;
+    options.table_infer_header = true;
+    EXPECT_EQ(markdownify::markdownify(html, options), "| 1 | 2 |\n| --- | --- |\n| 3 | 4 |");
+}
+
+TEST(TablesTest, Spans) {
+    std::string html = "<table><tr><th>A</th><th>B</th><th>C</th></tr>"
+                       "<tr><td rowspan=\"2\">1</td><td colspan=\"2\">2</td></tr>"
+                       "<tr><td>3</td><td>4</td></tr></table>";
+    EXPECT_EQ(markdownify::markdownify(html),
+              "| A | B | C |\n| --- | --- | --- |\n| 1 | 2 |  |\n|  | 3 | 4 |");
+}
+
+TEST(TablesTest, CellTextStaysOnOneLine) {
+    std::string html = "<table><tr><th>a|b</th><th><p>x</p>y<br>z</th></tr></table>";
+    EXPECT_EQ(markdownify::markdownify(html), "| a\\|b | x y z |\n| --- | --- |");
+}
+
+TEST(TablesTest, AlignColumns) {
+    markdownify::Options options;
+    options.table_align_columns = true;
+    std::string html = "<table><tr><th align=\"left\">Name</th>"
+                       "<th style=\"text-align: right\">Qty</th></tr>"
+                       "<tr><td>apple</td><td>3</td></tr></table>";
+    EXPECT_EQ(markdownify::markdownify(html, options),
+              "| Name  | Qty |\n| :---- | --: |\n| apple |   3 |");
+}
+
+TEST(TablesTest, AlignColumnsByDisplayWidth) {
+    markdownify::Options options;
+    options.table_align_columns = true;
+    std::string html = "<table><tr><th>Word</th></tr><tr><td>\u4e2d\u6587</td></tr>"
+                       "<tr><td>e\u0301</td></tr></table>";
+    EXPECT_EQ(markdownify::markdownify(html, options),
+              "| Word |\n| ---- |\n| \u4e2d\u6587 |\n| e\u0301    |");
+}
+
+TEST(TablesTest, Caption) {
+    std::string html = "<table><caption>Totals</caption><tr><th>A</th></tr></table>";
+    EXPECT_EQ(markdownify::markdownify(html), "Totals\n\n| A |\n| --- |");
+}
+
+TEST(TablesTest, NestedTableKeepsItsText) {
+    std::string html = "<table><tr><th>H</th></tr><tr><td>outer <table>"
+                       "<tr><td>a|b</td><td>c</td></tr><tr><td>d</td></tr>"
+                       "</table>end</td></tr></table>";
+    EXPECT_EQ(markdownify::markdownify(html), "| H |\n| --- |\n| outer a\\|b c d end |");
+}
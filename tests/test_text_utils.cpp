@@ -0,0 +1,153 @@
+#include <markdownify/text_utils.hpp>
+#include <gtest/gtest.h>
+
+using markdownify::collapse_whitespace;
+using markdownify::display_width;
+using markdownify::escape_markdown;
+using markdownify::normalize_newlines;
+using markdownify::strip1_pre;
+using markdownify::strip_pre;
+using markdownify::wrap_text;
+using markdownify::wrap_text_in_place;
+
+TEST(TextUtilsTest, CollapseWhitespace) {
+    EXPECT_EQ(collapse_whitespace("a  b\t\tc \t d"), "a b c d");
+    EXPECT_EQ(collapse_whitespace("  lead\ntrail  "), " lead\ntrail ");
+    EXPECT_EQ(collapse_whitespace(""), "");
+}
+
+TEST(TextUtilsTest, CollapseWhitespaceAppendsToBuffer) {
+    std::string out = "> ";
+    collapse_whitespace(std::string_view("x   y"), out);
+    EXPECT_EQ(out, "> x y");
+}
+
+TEST(TextUtilsTest, NormalizeNewlines) {
+    EXPECT_EQ(normalize_newlines("a  \n\t b"), "a\nb");
+    EXPECT_EQ(normalize_newlines("a\r\n\r\nb  c"), "a\nb  c");
+    EXPECT_EQ(normalize_newlines(" \n"), "\n");
+    EXPECT_EQ(normalize_newlines("a \t"), "a \t");
+    EXPECT_EQ(normalize_newlines(""), "");
+}
+
+TEST(TextUtilsTest, StripPre) {
+    EXPECT_EQ(strip_pre("\n  \n  code\n  more  \n \n"), "  code\n  more");
+    EXPECT_EQ(strip_pre("  code"), "  code");
+    EXPECT_EQ(strip_pre(" \n \n"), "");
+}
+
+TEST(TextUtilsTest, Strip1Pre) {
+    EXPECT_EQ(strip1_pre("  \n\n  code\n\n  "), "\n  code\n");
+    EXPECT_EQ(strip1_pre("  code  "), "  code  ");
+    EXPECT_EQ(strip1_pre(" \n"), "");
+}
+
+TEST(TextUtilsTest, StripPreAppendsToBuffer) {
+    std::string out = "```\n";
+    strip_pre(std::string_view("\ncode\n"), out);
+    strip1_pre(std::string_view("\nmore\n"), out);
+    EXPECT_EQ(out, "```\ncodemore");
+}
+
+TEST(TextUtilsTest, EscapeMarkdownAsterisksAndUnderscores) {
+    EXPECT_EQ(escape_markdown("a*b_c", true, true, false), "a\\*b\\_c");
+    EXPECT_EQ(escape_markdown("a*b_c", false, true, false), "a*b\\_c");
+    EXPECT_EQ(escape_markdown("a*b_c", true, false, false), "a\\*b_c");
+    EXPECT_EQ(escape_markdown("snake_case_name", true, true, false), "snake\\_case\\_name");
+    EXPECT_EQ(escape_markdown("plain text - 1. # x", true, true, false), "plain text - 1. # x");
+}
+
+TEST(TextUtilsTest, EscapeMarkdownMisc) {
+    EXPECT_EQ(escape_markdown("- item", false, false, true), "\\- item");
+    EXPECT_EQ(escape_markdown("-- a", false, false, true), "\\-- a");
+    EXPECT_EQ(escape_markdown("a-b", false, false, true), "a-b");
+    EXPECT_EQ(escape_markdown("## h", false, false, true), "\\## h");
+    EXPECT_EQ(escape_markdown("####### h", false, false, true), "####### h");
+    EXPECT_EQ(escape_markdown("1. a", false, false, true), "1\\. a");
+    EXPECT_EQ(escape_markdown("x 12) y", false, false, true), "x 12\\) y");
+    EXPECT_EQ(escape_markdown("1234567890. a", false, false, true), "1234567890. a");
+    EXPECT_EQ(escape_markdown("1.1. x", false, false, true), "1.1. x");
+}
+
+// A rule's trailing whitespace is consumed by its match and cannot start the
+// next one, as with std::regex_replace.
+TEST(TextUtilsTest, EscapeMarkdownMiscMatchesDoNotOverlap) {
+    EXPECT_EQ(escape_markdown("- - -", false, false, true), "\\- - \\-");
+    EXPECT_EQ(escape_markdown("# # #", false, false, true), "\\# # \\#");
+    EXPECT_EQ(escape_markdown(" -\n-", false, false, true), " \\-\n-");
+    EXPECT_EQ(escape_markdown("- # 1.", false, false, true), "\\- \\# 1\\.");
+}
+
+TEST(TextUtilsTest, EscapeMarkdownLongText) {
+    std::string text(1000, 'x');
+    text[3] = '_';
+    text[500] = '*';
+    text[999] = '_';
+
+    std::string expected = text;
+    expected.replace(999, 1, "\\_");
+    expected.replace(500, 1, "\\*");
+    expected.replace(3, 1, "\\_");
+    EXPECT_EQ(escape_markdown(text, true, true, true), expected);
+}
+
+TEST(TextUtilsTest, EscapeMarkdownAppendsToBuffer) {
+    std::string out = "> ";
+    escape_markdown(std::string_view("a_b"), false, true, false, out);
+    EXPECT_EQ(out, "> a\\_b");
+}
+
+TEST(TextUtilsTest, DisplayWidth) {
+    EXPECT_EQ(display_width("abc"), 3u);
+    EXPECT_EQ(display_width("caf\xC3\xA9"), 4u);
+    EXPECT_EQ(display_width("cafe\xCC\x81"), 4u);
+    EXPECT_EQ(display_width("\xE6\x97\xA5\xE6\x9C\xAC"), 4u);
+    EXPECT_EQ(display_width("\xF0\x9F\x98\x80"), 2u);
+    EXPECT_EQ(display_width("\xFF\xE6\x97"), 3u);
+}
+
+TEST(TextUtilsTest, WrapText) {
+    EXPECT_EQ(wrap_text("one two three four", 9), "one two\nthree\nfour");
+    EXPECT_EQ(wrap_text("  one   two  ", 80), "one two");
+    EXPECT_EQ(wrap_text("unbreakable word", 4), "unbreakable\nword");
+    EXPECT_EQ(wrap_text("one two", 0), "one two");
+}
+
+TEST(TextUtilsTest, WrapTextCountsColumns) {
+    // Eight accented letters fit in 8 columns, though they take 16 bytes.
+    std::string accented;
+    for (int i = 0; i < 8; ++i) {
+        accented += "\xC3\xA9";
+    }
+    EXPECT_EQ(wrap_text(accented + " " + accented, 17), accented + " " + accented);
+    EXPECT_EQ(wrap_text(accented + " " + accented, 16), accented + "\n" + accented);
+
+    std::string wide = "\xE6\x97\xA5\xE6\x9C\xAC";
+    EXPECT_EQ(wrap_text(wide + " " + wide + " " + wide, 9), wide + " " + wide + "\n" + wide);
+}
+
+TEST(TextUtilsTest, WrapTextKeepsInlineSyntax) {
+    EXPECT_EQ(wrap_text("see [the long link text](http://x.y \"a title\") now", 10),
+              "see\n[the long link text](http://x.y \"a title\")\nnow");
+    EXPECT_EQ(wrap_text("run `make all tests` first", 10), "run\n`make all tests`\nfirst");
+    EXPECT_EQ(wrap_text("a ``x ` y`` b", 3), "a\n``x ` y``\nb");
+    EXPECT_EQ(wrap_text("![an image](a.png) [x", 5), "![an image](a.png)\n[x");
+    EXPECT_EQ(wrap_text("\\[not a link](x) y", 6), "\\[not\na\nlink](x)\ny");
+}
+
+TEST(TextUtilsTest, WrapTextKeepsHardBreaks) {
+    EXPECT_EQ(wrap_text("one two  \nthree four", 5), "one\ntwo  \nthree\nfour");
+    EXPECT_EQ(wrap_text("one\\\ntwo", 80), "one\\\ntwo");
+    EXPECT_EQ(wrap_text("one\\\\\ntwo", 80), "one\\\\ two");
+    EXPECT_EQ(wrap_text("soft\nbreak", 80), "soft break");
+}
+
+TEST(TextUtilsTest, WrapTextInPlace) {
+    std::string text = "> one two three";
+    wrap_text_in_place(text, 2, 7);
+    EXPECT_EQ(text, "> one two\nthree");
+
+    std::string out = "> ";
+    wrap_text(std::string_view("one   two"), 3, out);
+    EXPECT_EQ(out, "> one\ntwo");
+}
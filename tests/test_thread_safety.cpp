@@ -0,0 +1,68 @@
+#include <markdownify/markdownify.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+
+// Build with -DMARKDOWNIFY_ENABLE_TSAN=ON to have ThreadSanitizer check
+// these tests for races.
+
+namespace {
+
+std::vector<std::string> make_documents() {
+    std::vector<std::string> docs;
+    for (int i = 0; i < 40; ++i) {
+        std::string html = "<h1>Doc " + std::to_string(i) + "</h1><ol>";
+        for (int j = 0; j <= i % 5; ++j) {
+            html += "<li>step <em>" + std::to_string(j) + "</em><ol><li>a</li><li>b</li></ol></li>";
+        }
+        html += "</ol><ul><li>x<ul><li>y</li></ul></li></ul>"
+                "<pre><code class=\"language-cpp\">int x = " + std::to_string(i) + ";</code></pre>"
+                "<table><tr><th>k</th></tr><tr><td>v_" + std::to_string(i) + "</td></tr></table>"
+                "<blockquote><p>quoted *text*</p></blockquote>";
+        docs.push_back(html);
+    }
+    return docs;
+}
+
+}
+
+TEST(ThreadSafetyTest, SharedConverterMatchesSerialConversion) {
+    markdownify::Options options;
+    options.code_language = "text";
+    options.bullets = {"-", "+"};
+
+    std::vector<std::string> docs = make_documents();
+    std::vector<std::string> expected;
+    for (const std::string& html : docs) {
+        expected.push_back(markdownify::MarkdownConverter(options).convert(html));
+    }
+
+    const markdownify::MarkdownConverter shared(options);
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t] {
+            for (int round = 0; round < 20; ++round) {
+                for (std::size_t i = 0; i < docs.size(); ++i) {
+                    std::size_t index = (i + t * 5) % docs.size();
+                    if (shared.convert(docs[index]) != expected[index]) {
+                        mismatches.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(mismatches.load(), 0);
+}
+
+TEST(ThreadSafetyTest, ListCountersAreScopedToTheCall) {
+    const markdownify::MarkdownConverter converter;
+    std::string html = "<ol><li>one</li><li>two</li></ol>";
+
+    EXPECT_EQ(converter.convert(html), "1. one\n2. two");
+    EXPECT_EQ(converter.convert(html), "1. one\n2. two");
+}
@@ -0,0 +1,36 @@
+#include "worker_pool.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+
+using markdownify::detail::WorkerPool;
+
+TEST(WorkerPoolTest, RunsEveryWorkerOnce) {
+    WorkerPool pool;
+    for (unsigned workers : {1u, 2u, 5u}) {
+        std::vector<std::atomic<int>> calls(workers);
+        pool.run(workers, [&](unsigned slot) { ++calls[slot]; });
+        for (unsigned i = 0; i < workers; ++i) {
+            EXPECT_EQ(calls[i].load(), 1) << workers << " " << i;
+        }
+    }
+}
+
+TEST(WorkerPoolTest, RethrowsAfterAllWorkersReturn) {
+    WorkerPool pool;
+    for (unsigned thrower : {0u, 2u}) {
+        std::atomic<unsigned> finished{0};
+        EXPECT_THROW(pool.run(4, [&](unsigned slot) {
+            if (slot == thrower) {
+                throw std::runtime_error("task failed");
+            }
+            ++finished;
+        }), std::runtime_error);
+        EXPECT_EQ(finished.load(), 3u);
+    }
+
+    // The pool stays usable.
+    std::atomic<unsigned> finished{0};
+    pool.run(4, [&](unsigned) { ++finished; });
+    EXPECT_EQ(finished.load(), 4u);
+}
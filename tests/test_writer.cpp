@@ -0,0 +1,39 @@
+#include <markdownify/writer.hpp>
+#include <gtest/gtest.h>
+
+using markdownify::MarkdownWriter;
+
+TEST(WriterTest, ReplaceInPlaceAndResize) {
+    MarkdownWriter out;
+    out.append("`code` tail");
+    out.replace(0, 1, "`");
+    EXPECT_EQ(out.view(), "`code` tail");
+    out.replace(0, 1, "`` ");
+    EXPECT_EQ(out.view(), "`` code` tail");
+    out.insert(3, ">");
+    out.erase(out.size() - 5, 5);
+    EXPECT_EQ(out.view(), "`` >code`");
+    EXPECT_EQ(out.view(3), ">code`");
+}
+
+TEST(WriterTest, PrefixLinesFollowsGetline) {
+    MarkdownWriter out;
+    out.append("keep:a\n\nb");
+    out.prefix_lines(5, "- ", "  ");
+    EXPECT_EQ(out.view(), "keep:- a\n  \n  b\n");
+
+    out.clear();
+    out.append("x\ny\n");
+    out.prefix_lines(0, "> ", "> ");
+    EXPECT_EQ(out.view(), "> x\n> y\n");
+
+    out.clear();
+    out.append("\n");
+    out.prefix_lines(0, "1. ", "  ");
+    EXPECT_EQ(out.view(), "1. \n");
+
+    out.clear();
+    out.append("unchanged");
+    out.prefix_lines(9, "> ", "> ");
+    EXPECT_EQ(out.view(), "unchanged");
+}
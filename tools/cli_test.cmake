@@ -0,0 +1,75 @@
+# Converts a small directory tree with the markdownify tool and checks the
+# mirrored output. Run by ctest with -DCLI=<tool> -DWORK_DIR=<scratch dir>.
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(WRITE ${WORK_DIR}/in/index.html "<p>See <b>docs</b> &amp; <a href=\"/a\">more</a>.</p>")
+file(WRITE ${WORK_DIR}/in/guide/intro.htm "<ul><li>one</li><li>two</li></ul>")
+file(WRITE ${WORK_DIR}/in/guide/notes.txt "not html")
+
+execute_process(
+    COMMAND ${CLI} --jobs 2 --bullets - -o ${WORK_DIR}/out ${WORK_DIR}/in
+    RESULT_VARIABLE result
+    ERROR_VARIABLE summary
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "markdownify failed (${result}): ${summary}")
+endif()
+if(NOT summary MATCHES "converted 2 files.*0 failed")
+    message(FATAL_ERROR "unexpected summary: ${summary}")
+endif()
+
+file(READ ${WORK_DIR}/out/index.md index)
+if(NOT index STREQUAL "See **docs** & [more](/a).\n")
+    message(FATAL_ERROR "unexpected index.md: ${index}")
+endif()
+
+file(READ ${WORK_DIR}/out/guide/intro.md intro)
+if(NOT intro STREQUAL "- one\n- two\n")
+    message(FATAL_ERROR "unexpected guide/intro.md: ${intro}")
+endif()
+
+if(EXISTS ${WORK_DIR}/out/guide/notes.md)
+    message(FATAL_ERROR "notes.txt should not have been converted")
+endif()
+
+execute_process(
+    COMMAND ${CLI} --quiet ${WORK_DIR}/in/missing.html
+    RESULT_VARIABLE result
+    ERROR_QUIET
+)
+if(result EQUAL 0)
+    message(FATAL_ERROR "a missing input should fail")
+endif()
+
+file(WRITE ${WORK_DIR}/deep.html "<div><p><b>x</b></p></div>")
+execute_process(
+    COMMAND ${CLI} --max-depth 2 -
+    INPUT_FILE ${WORK_DIR}/deep.html
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE deep
+)
+if(NOT result EQUAL 0 OR NOT deep STREQUAL "x\n")
+    message(FATAL_ERROR "unexpected --max-depth output (${result}): ${deep}")
+endif()
+
+file(WRITE ${WORK_DIR}/table.html "<table><tr><th>a</th></tr><tr><td>ccc</td></tr></table>")
+execute_process(
+    COMMAND ${CLI} --table-align-columns -
+    INPUT_FILE ${WORK_DIR}/table.html
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE table
+)
+if(NOT result EQUAL 0 OR NOT table STREQUAL "| a   |\n| --- |\n| ccc |\n")
+    message(FATAL_ERROR "unexpected --table-align-columns output (${result}): ${table}")
+endif()
+
+file(WRITE ${WORK_DIR}/marks.html "<p><a href=\"/a\">x</a><sub>2</sub><sup>3</sup></p>")
+execute_process(
+    COMMAND ${CLI} --default-title --sub-symbol ~ --sup-symbol <sup> -
+    INPUT_FILE ${WORK_DIR}/marks.html
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE marks
+)
+if(NOT result EQUAL 0 OR NOT marks STREQUAL "[x](/a \"/a\")~2~<sup>3</sup>\n")
+    message(FATAL_ERROR "unexpected --default-title/--sub-symbol output (${result}): ${marks}")
+endif()
\ No newline at end of file
@@ -0,0 +1,490 @@
+#include <markdownify/markdownify.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <glob.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const kUsage = R"(Usage: markdownify [options] <input>...
+
+Converts HTML files to Markdown. An input is a file, a directory (converted
+recursively) or a glob pattern; "-" reads standard input and writes standard
+output. Without --output, each result is written next to its input with a
+.md extension.
+
+Tool options:
+  -o, --output DIR            write results under DIR, mirroring the input tree
+  -j, --jobs N                convert N files at a time (default: all cores,
+                              at most 4 per core)
+      --extensions LIST       file extensions taken from directories
+                              (default: html,htm)
+  -q, --quiet                 do not print the summary
+  -h, --help                  show this help
+
+Conversion options:
+      --no-autolinks          always write [text](url) links
+      --bullets CHARS         bullets for nesting levels (default: *+-)
+      --code-language LANG    language of code blocks
+      --convert TAGS          convert only these tags (comma-separated)
+      --strip TAGS            drop these tags with their content (comma-separated)
+      --unwrap TAGS           convert only the content of these tags
+      --skip TAGS             drop these tags with their content, overriding
+                              --convert
+      --default-title         use the href as link title
+      --no-escape-asterisks   do not escape *
+      --no-escape-underscores do not escape _
+      --escape-misc           escape other Markdown punctuation
+      --heading-style STYLE   atx, atx_closed, setext or underlined
+      --keep-inline-images-in TAGS
+                              keep images inline inside these tags
+      --max-depth N           reduce elements nested deeper than N to their
+                              text (default: 0, no limit)
+      --newline-style STYLE   spaces or backslash
+      --strip-document MODE   none, lstrip, rstrip, strip or strip_one
+      --strip-pre MODE        none, lstrip, rstrip, strip or strip_one
+      --strong-em-symbol SYM  asterisk or underscore
+      --sub-symbol TEXT       markup around <sub> text
+      --sup-symbol TEXT       markup around <sup> text
+      --table-infer-header    use the first row of tables as header
+      --table-align-columns   pad table cells so that the columns line up
+      --preserve-html-tables  keep tables as HTML
+      --wrap                  wrap paragraphs
+      --wrap-width N          wrap width (default: 80)
+)";
+
+struct Job {
+    fs::path input;
+    fs::path output;
+};
+
+struct Settings {
+    markdownify::Options options;
+    std::string output_dir;
+    unsigned jobs = 0;
+    std::vector<std::string> extensions = {".html", ".htm"};
+    bool quiet = false;
+    std::vector<std::string> inputs;
+};
+
+[[noreturn]] void usage_error(const std::string& message) {
+    std::cerr << "markdownify: " << message << "\n"
+              << "Try 'markdownify --help' for more information.\n";
+    std::exit(2);
+}
+
+std::vector<std::string> split_list(const std::string& text) {
+    std::vector<std::string> items;
+    std::size_t begin = 0;
+    while (begin <= text.size()) {
+        std::size_t end = text.find(',', begin);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        if (end > begin) {
+            items.push_back(text.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+    return items;
+}
+
+markdownify::StripMode parse_strip_mode(const std::string& flag, const std::string& value) {
+    if (value == "none") return markdownify::StripMode::NONE;
+    if (value == "lstrip") return markdownify::StripMode::LSTRIP;
+    if (value == "rstrip") return markdownify::StripMode::RSTRIP;
+    if (value == "strip") return markdownify::StripMode::STRIP;
+    if (value == "strip_one") return markdownify::StripMode::STRIP_ONE;
+    usage_error("invalid value '" + value + "' for " + flag);
+}
+
+int parse_count(const std::string& flag, const std::string& value) {
+    char* end = nullptr;
+    long number = std::strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || number < 0 || number > 1000000) {
+        usage_error("invalid value '" + value + "' for " + flag);
+    }
+    return static_cast<int>(number);
+}
+
+Settings parse_arguments(int argc, char** argv) {
+    Settings settings;
+    markdownify::Options& options = settings.options;
+    bool only_inputs = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (only_inputs || arg == "-" || arg.empty() || arg[0] != '-') {
+            settings.inputs.push_back(arg);
+            continue;
+        }
+        if (arg == "--") {
+            only_inputs = true;
+            continue;
+        }
+
+        std::string value;
+        bool has_inline_value = false;
+        std::size_t equals = arg.find('=');
+        if (arg.compare(0, 2, "--") == 0 && equals != std::string::npos) {
+            value = arg.substr(equals + 1);
+            arg.resize(equals);
+            has_inline_value = true;
+        }
+        auto take_value = [&]() -> std::string {
+            if (has_inline_value) {
+                return value;
+            }
+            if (i + 1 >= argc) {
+                usage_error("option " + arg + " needs a value");
+            }
+            return argv[++i];
+        };
+        auto switch_flag = [&] {
+            if (has_inline_value) {
+                usage_error("option " + arg + " takes no value");
+            }
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            std::cout << kUsage;
+            std::exit(0);
+        } else if (arg == "-o" || arg == "--output") {
+            settings.output_dir = take_value();
+        } else if (arg == "-j" || arg == "--jobs") {
+            settings.jobs = static_cast<unsigned>(parse_count(arg, take_value()));
+        } else if (arg == "--extensions") {
+            settings.extensions.clear();
+            for (std::string extension : split_list(take_value())) {
+                if (extension[0] != '.') {
+                    extension.insert(0, ".");
+                }
+                settings.extensions.push_back(extension);
+            }
+        } else if (arg == "-q" || arg == "--quiet") {
+            switch_flag();
+            settings.quiet = true;
+        } else if (arg == "--no-autolinks") {
+            switch_flag();
+            options.autolinks = false;
+        } else if (arg == "--bullets") {
+            std::string bullets = take_value();
+            if (bullets.empty()) {
+                usage_error("--bullets needs at least one character");
+            }
+            options.bullets.clear();
+            for (char c : bullets) {
+                options.bullets.push_back(std::string(1, c));
+            }
+        } else if (arg == "--code-language") {
+            options.code_language = take_value();
+        } else if (arg == "--convert") {
+            for (const std::string& tag : split_list(take_value())) {
+                options.convert_tags.insert(tag);
+            }
+        } else if (arg == "--strip") {
+            for (const std::string& tag : split_list(take_value())) {
+                options.strip_tags.insert(tag);
+            }
+        } else if (arg == "--unwrap") {
+            for (const std::string& tag : split_list(take_value())) {
+                options.tag_actions[tag] = markdownify::TagAction::UNWRAP;
+            }
+        } else if (arg == "--skip") {
+            for (const std::string& tag : split_list(take_value())) {
+                options.tag_actions[tag] = markdownify::TagAction::SKIP;
+            }
+        } else if (arg == "--default-title") {
+            switch_flag();
+            options.default_title = true;
+        } else if (arg == "--no-escape-asterisks") {
+            switch_flag();
+            options.escape_asterisks = false;
+        } else if (arg == "--no-escape-underscores") {
+            switch_flag();
+            options.escape_underscores = false;
+        } else if (arg == "--escape-misc") {
+            switch_flag();
+            options.escape_misc = true;
+        } else if (arg == "--heading-style") {
+            std::string style = take_value();
+            if (style == "atx") {
+                options.heading_style = markdownify::HeadingStyle::ATX;
+            } else if (style == "atx_closed") {
+                options.heading_style = markdownify::HeadingStyle::ATX_CLOSED;
+            } else if (style == "setext" || style == "underlined") {
+                options.heading_style = markdownify::HeadingStyle::SETEXT;
+            } else {
+                usage_error("invalid value '" + style + "' for " + arg);
+            }
+        } else if (arg == "--keep-inline-images-in") {
+            options.keep_inline_images_in = split_list(take_value());
+        } else if (arg == "--max-depth") {
+            options.max_depth = parse_count(arg, take_value());
+        } else if (arg == "--newline-style") {
+            std::string style = take_value();
+            if (style == "spaces") {
+                options.newline_style = markdownify::NewlineStyle::SPACES;
+            } else if (style == "backslash") {
+                options.newline_style = markdownify::NewlineStyle::BACKSLASH;
+            } else {
+                usage_error("invalid value '" + style + "' for " + arg);
+            }
+        } else if (arg == "--strip-document") {
+            options.strip_document = parse_strip_mode(arg, take_value());
+        } else if (arg == "--strip-pre") {
+            options.strip_pre = parse_strip_mode(arg, take_value());
+        } else if (arg == "--strong-em-symbol") {
+            std::string symbol = take_value();
+            if (symbol == "asterisk") {
+                options.strong_em_symbol = markdownify::StrongEmSymbol::ASTERISK;
+            } else if (symbol == "underscore") {
+                options.strong_em_symbol = markdownify::StrongEmSymbol::UNDERSCORE;
+            } else {
+                usage_error("invalid value '" + symbol + "' for " + arg);
+            }
+        } else if (arg == "--sub-symbol") {
+            options.sub_symbol = take_value();
+        } else if (arg == "--sup-symbol") {
+            options.sup_symbol = take_value();
+        } else if (arg == "--table-infer-header") {
+            switch_flag();
+            options.table_infer_header = true;
+        } else if (arg == "--table-align-columns") {
+            switch_flag();
+            options.table_align_columns = true;
+        } else if (arg == "--preserve-html-tables") {
+            switch_flag();
+            options.preserve_html_tables = true;
+        } else if (arg == "--wrap") {
+            switch_flag();
+            options.wrap = true;
+        } else if (arg == "--wrap-width") {
+            options.wrap_width = parse_count(arg, take_value());
+        } else {
+            usage_error("unknown option " + arg);
+        }
+
+    }
+
+    if (settings.inputs.empty()) {
+        usage_error("no input files");
+    }
+    return settings;
+}
+
+bool has_wildcard(const std::string& text) {
+    return text.find_first_of("*?[") != std::string::npos;
+}
+
+// The leading directories of a glob pattern that contain no wildcards;
+// matches are mirrored relative to it.
+fs::path glob_base(const std::string& pattern) {
+    fs::path base;
+    for (const fs::path& part : fs::path(pattern).parent_path()) {
+        if (has_wildcard(part.string())) {
+            break;
+        }
+        base /= part;
+    }
+    return base;
+}
+
+std::vector<std::string> expand_glob(const std::string& pattern) {
+    std::vector<std::string> matches;
+#ifndef _WIN32
+    glob_t result;
+    if (::glob(pattern.c_str(), 0, nullptr, &result) == 0) {
+        for (std::size_t i = 0; i < result.gl_pathc; ++i) {
+            matches.push_back(result.gl_pathv[i]);
+        }
+    }
+    ::globfree(&result);
+#endif
+    return matches;
+}
+
+bool wanted_extension(const fs::path& path, const std::vector<std::string>& extensions) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return std::find(extensions.begin(), extensions.end(), extension) != extensions.end();
+}
+
+fs::path output_path(const Settings& settings, const fs::path& input, const fs::path& relative) {
+    fs::path target = settings.output_dir.empty() ? input : fs::path(settings.output_dir) / relative;
+    return target.replace_extension(".md");
+}
+
+// Expands the inputs into one job per file. Returns false if an input does
+// not exist.
+bool collect_jobs(const Settings& settings, std::vector<Job>& jobs) {
+    bool ok = true;
+    for (const std::string& input : settings.inputs) {
+        std::error_code error;
+        fs::path path(input);
+
+        if (fs::is_directory(path, error)) {
+            fs::recursive_directory_iterator it(path, fs::directory_options::skip_permission_denied,
+                                                error);
+            for (; !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+                if (it->is_regular_file(error) && wanted_extension(it->path(), settings.extensions)) {
+                    jobs.push_back({it->path(),
+                                    output_path(settings, it->path(),
+                                                it->path().lexically_relative(path))});
+                }
+            }
+            if (error) {
+                std::cerr << "markdownify: " << input << ": " << error.message() << "\n";
+                ok = false;
+            }
+        } else if (fs::exists(path, error)) {
+            jobs.push_back({path, output_path(settings, path, path.filename())});
+        } else if (has_wildcard(input)) {
+            fs::path base = glob_base(input);
+            std::vector<std::string> matches = expand_glob(input);
+            if (matches.empty()) {
+                std::cerr << "markdownify: " << input << ": no matching files\n";
+                ok = false;
+            }
+            for (const std::string& match : matches) {
+                fs::path match_path(match);
+                if (fs::is_regular_file(match_path, error)) {
+                    jobs.push_back({match_path,
+                                    output_path(settings, match_path,
+                                                match_path.lexically_relative(base))});
+                }
+            }
+        } else {
+            std::cerr << "markdownify: " << input << ": No such file or directory\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool write_file(const fs::path& path, std::string_view text, std::string& error) {
+    std::error_code ec;
+    if (path.has_parent_path()) {
+        fs::create_directories(path.parent_path(), ec);
+        if (ec) {
+            error = ec.message();
+            return false;
+        }
+    }
+
+    std::FILE* file = std::fopen(path.string().c_str(), "wb");
+    if (!file) {
+        error = "cannot create " + path.string();
+        return false;
+    }
+    bool written = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    written = std::fputc('\n', file) != EOF && written;
+    if (std::fclose(file) != 0 || !written) {
+        error = "cannot write " + path.string();
+        return false;
+    }
+    return true;
+}
+
+int convert_stdin(const markdownify::MarkdownConverter& converter) {
+    std::string html((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+    converter.convert(html, std::cout);
+    std::cout << "\n";
+    return std::cout ? 0 : 1;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Settings settings = parse_arguments(argc, argv);
+    const markdownify::MarkdownConverter converter(settings.options);
+
+    if (settings.inputs.size() == 1 && settings.inputs[0] == "-") {
+        return convert_stdin(converter);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<Job> jobs;
+    bool inputs_ok = collect_jobs(settings, jobs);
+
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    unsigned threads = settings.jobs;
+    if (threads == 0) {
+        threads = hardware;
+    }
+    threads = std::min(threads, hardware * markdownify::kMaxThreadsPerCore);
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(jobs.size(), 1)));
+
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> converted{0};
+    std::atomic<std::size_t> failed{0};
+    std::atomic<std::uintmax_t> bytes{0};
+    std::mutex error_mutex;
+
+    auto work = [&] {
+        markdownify::ConversionSession session(converter);
+        for (std::size_t index; (index = next.fetch_add(1)) < jobs.size();) {
+            const Job& job = jobs[index];
+            std::string error;
+            try {
+                std::optional<std::string_view> markdown = session.convert_file(job.input.string());
+                if (!markdown) {
+                    error = "cannot read file";
+                } else if (write_file(job.output, *markdown, error)) {
+                    std::error_code ec;
+                    std::uintmax_t size = fs::file_size(job.input, ec);
+                    bytes.fetch_add(ec ? 0 : size);
+                    converted.fetch_add(1);
+                    continue;
+                }
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+
+            failed.fetch_add(1);
+            std::lock_guard<std::mutex> lock(error_mutex);
+            std::cerr << "markdownify: " << job.input.string() << ": " << error << "\n";
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; ++t) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    if (!settings.quiet) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double megabytes = static_cast<double>(bytes.load()) / (1024.0 * 1024.0);
+        std::fprintf(stderr,
+                     "converted %zu files (%.1f MiB) in %.2f s with %u jobs: "
+                     "%.1f files/s, %.1f MiB/s, %zu failed\n",
+                     converted.load(), megabytes, seconds, threads,
+                     seconds > 0 ? converted.load() / seconds : 0.0,
+                     seconds > 0 ? megabytes / seconds : 0.0, failed.load());
+    }
+
+    return inputs_ok && failed.load() == 0 ? 0 : 1;
+}